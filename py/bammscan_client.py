@@ -0,0 +1,76 @@
+'''
+ This script sends a scan request to a resident BaMMScan, started with
+   BaMMScan OUTDIR SEQFILE --BaMMFile ... --serve SOCKET
+ and writes the reply: the occurrences of each motif after a line "# <motif name>"
+ in the format of the .occurrence or .bed files of BaMMScan
+'''
+
+
+import argparse
+import socket
+import sys
+
+
+def create_parser():
+    parser = argparse.ArgumentParser()
+    parser.add_argument('socket', help='Unix domain socket of the resident BaMMScan')
+    parser.add_argument('fasta_file', nargs='?', default='-', help='sequences to scan, - for stdin')
+    parser.add_argument('--pvalCutoff', type=float, default=None)
+    parser.add_argument('--format', choices=['occurrence', 'bed'], default=None)
+    parser.add_argument('--shutdown', action='store_true', help='stop the server')
+    parser.add_argument('-o', default=None, help='output file, stdout by default')
+    return parser
+
+
+def scan(socket_path, fasta, pval_cutoff=None, fmt=None, shutdown=False):
+    # one request per connection: options and sequences in, reply until the server closes
+    request = []
+    if pval_cutoff is not None:
+        request.append('#pvalCutoff {}\n'.format(pval_cutoff))
+    if fmt is not None:
+        request.append('#format {}\n'.format(fmt))
+    if shutdown:
+        request.append('#shutdown\n')
+    request.append(fasta)
+
+    sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+    sock.connect(socket_path)
+    sock.sendall(''.join(request).encode())
+    sock.shutdown(socket.SHUT_WR)
+    reply = []
+    while True:
+        data = sock.recv(1 << 16)
+        if not data:
+            break
+        reply.append(data)
+    sock.close()
+
+    reply = b''.join(reply).decode()
+    if reply.startswith('Error: '):
+        raise RuntimeError(reply.strip())
+    return reply
+
+
+def main():
+    parser = create_parser()
+    args = parser.parse_args()
+
+    fasta = ''
+    if not args.shutdown:
+        if args.fasta_file == '-':
+            fasta = sys.stdin.read()
+        else:
+            with open(args.fasta_file) as fh:
+                fasta = fh.read()
+
+    reply = scan(args.socket, fasta, args.pvalCutoff, args.format, args.shutdown)
+
+    if args.o is None:
+        sys.stdout.write(reply)
+    else:
+        with open(args.o, 'w') as fh:
+            fh.write(reply)
+
+
+if __name__ == '__main__':
+    main()
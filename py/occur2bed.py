@@ -2,6 +2,7 @@
  This script is for converting .occurrence file to .bed file
  The output file contains:
  CHROM START END STRAND
+ BaMMScan --outputFormat bed writes such a BED file directly.
 '''
 
 
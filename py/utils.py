@@ -380,5 +380,47 @@ def write_bamm(pwm, ofile):
             print(' '.join(['{:.4e}'.format(x+eps) for x in pwm[i]]) + ' \n', file=fh)
 
 
+def read_lhb(lhb_file):
+    # read binary positional likelihoods (.lhb) as one float array per sequence
+    lhb = np.memmap(lhb_file, dtype=np.uint8, mode='r')
+    assert bytes(lhb[:7]) == b'BaMMlhb', 'not a positional likelihood file'
+    value_type, value_bytes = np.frombuffer(lhb, np.uint32, 2, 8)
+    n, d = np.frombuffer(lhb, np.uint64, 2, 16)
+    start = 32
+    dictionary = np.frombuffer(lhb, np.float32, int(d), start)
+    start += 4 * int(d)
+    offsets = np.frombuffer(lhb, np.uint64, int(n) + 1, start).astype(np.int64)
+    start += 8 * (int(n) + 1)
+    if value_type == 0:
+        values = np.frombuffer(lhb, np.float32, offsets[-1], start)
+    elif value_type == 1:
+        values = np.frombuffer(lhb, np.float16, offsets[-1], start).astype(np.float32)
+    else:
+        dtype = {1: np.uint8, 2: np.uint16, 4: np.uint32}[int(value_bytes)]
+        values = dictionary[np.frombuffer(lhb, dtype, offsets[-1], start)]
+    return [values[offsets[i]:offsets[i + 1]] for i in range(int(n))]
+
+
+def read_occurrences(bin_file):
+    # read a binary occurrence table (BaMMScan --outputFormat binary) as columns
+    occ = np.memmap(bin_file, dtype=np.uint8, mode='r')
+    assert bytes(occ[:7]) == b'BaMMocc', 'not a binary occurrence file'
+    assert occ[7] == 2, 'unsupported version of the binary occurrence file'
+    w, n, r = (int(x) for x in np.frombuffer(occ, np.uint64, 3, 8))
+    start = 32
+    offsets = np.frombuffer(occ, np.uint64, n + 1, start).astype(np.int64)
+    start += 8 * (n + 1)
+    letters = bytes(occ[start:start + offsets[-1]]).decode()
+    headers = [letters[offsets[i]:offsets[i + 1]] for i in range(n)]
+    start += (int(offsets[-1]) + 7) // 8 * 8
+    columns = {'headers': headers, 'width': w}
+    for name, dtype in [('seq', np.uint32), ('start', np.uint32), ('score', np.float32),
+                        ('p-value', np.float32), ('e-value', np.float32)]:
+        columns[name] = np.frombuffer(occ, dtype, r, start)
+        start += 4 * r
+    columns['strand'] = np.frombuffer(occ, 'S1', r, start)
+    return columns
+
+
 class MalformattedMemeError(ValueError):
     pass
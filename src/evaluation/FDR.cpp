@@ -1,12 +1,35 @@
 #include "FDR.h"
+#include <float.h>		// -FLT_MAX
+
+#ifdef OPENMP
+#include <omp.h>
+#endif
 
 FDR::FDR( std::vector<Sequence*> posSeqs, std::vector<Sequence*> negSeqs,
           Motif* motif, BackgroundModel* bgModel, size_t cvFold,
           bool mops, bool zoops, bool savePRs,
-          bool savePvalues, bool saveLogOdds){
+          bool savePvalues, bool saveLogOdds, size_t nBins )
+        : FDR( posSeqs, negSeqs, NULL, motif, bgModel, cvFold, mops, zoops,
+               savePRs, savePvalues, saveLogOdds, nBins ){
+}
+
+FDR::FDR( std::vector<Sequence*> posSeqs, SeqSource* negSource,
+          Motif* motif, BackgroundModel* bgModel, size_t cvFold,
+          bool mops, bool zoops, bool savePRs,
+          bool savePvalues, bool saveLogOdds, size_t nBins )
+        : FDR( posSeqs, std::vector<Sequence*>(), negSource, motif, bgModel, cvFold,
+               mops, zoops, savePRs, savePvalues, saveLogOdds, nBins ){
+}
+
+FDR::FDR( std::vector<Sequence*> posSeqs, std::vector<Sequence*> negSeqs, SeqSource* negSource,
+          Motif* motif, BackgroundModel* bgModel, size_t cvFold,
+          bool mops, bool zoops, bool savePRs,
+          bool savePvalues, bool saveLogOdds, size_t nBins ){
 
 	posSeqs_	= posSeqs;
 	negSeqs_	= negSeqs;
+	negSource_	= negSource;
+	negN_		= ( negSource_ != NULL ) ? negSource_->getN() : negSeqs_.size();
 	q_ 			= motif->getQ();
 	motif_ 		= motif;
     bgModel_    = bgModel;
@@ -16,9 +39,43 @@ FDR::FDR( std::vector<Sequence*> posSeqs, std::vector<Sequence*> negSeqs,
     savePRs_    = savePRs;
     savePvalues_= savePvalues;
     saveLogOdds_= saveLogOdds;
+    nBins_      = nBins;
 	occ_frac_	= 0.0f;
 	occ_mult_	= 0.0f;
 
+	/**
+	 * Draw the test sets of all folds and the negative set once,
+	 * the negative set is the same for every fold
+	 */
+	testSets_.resize( cvFold_ );
+	for( size_t n = 0; n <= posSeqs_.size()-cvFold_; n+=cvFold_ ){
+		for( size_t f = 0; f < cvFold_; f++ ){
+			testSets_[f].push_back( posSeqs_[n+f] );
+		}
+	}
+	// every cvFold-th negative sequence; a generated set is scored with this stride
+	negSetN_ = negN_ / cvFold_;
+	for( size_t n = 0; n < negSeqs_.size() / cvFold_; n++ ){
+		negSet_.push_back( negSeqs_[n * cvFold_] );
+	}
+
+	// the scores of fold f are stored in the f-th slice of the score arrays
+	size_t W = motif_->getW();
+	posAllOffset_.assign( cvFold_+1, 0 );
+	posMaxOffset_.assign( cvFold_+1, 0 );
+	for( size_t f = 0; f < cvFold_; f++ ){
+		size_t LW1 = 0;
+		for( size_t n = 0; n < testSets_[f].size(); n++ ){
+			LW1 += testSets_[f][n]->getL() - W + 1;
+		}
+		posAllOffset_[f+1] = posAllOffset_[f] + LW1;
+		posMaxOffset_[f+1] = posMaxOffset_[f] + testSets_[f].size();
+	}
+	negAllN_ = 0;
+	for( size_t n = 0; n < negSetN_; n++ ){
+		negAllN_ += ( ( negSource_ != NULL ) ? negSource_->getL( n * cvFold_ ) : negSet_[n]->getL() ) - W + 1;
+	}
+
 }
 
 FDR::~FDR(){
@@ -27,107 +84,46 @@ FDR::~FDR(){
 
 void FDR::evaluateMotif( bool EMoptimize, bool CGSoptimize, bool optimizeQ, bool advanceEM, float frac, size_t perLoopThreads ){
 
-	std::vector<std::vector<float>> mops_scores;
-	std::vector<float> 				zoops_scores;
-    float updatedQ = q_;            // obtain the updated q
-
     /**
-	 * Cross validation
-	 */
-#pragma omp parallel for num_threads(perLoopThreads)
-	for( size_t fold = 0; fold < cvFold_; fold++ ){
-
-		// deep copy the initial motif
-		Motif* motif = new Motif( *motif_ );
-
-		/**
-		 * Draw sequences for each training, test and negative sets
-		 */
-		std::vector<Sequence*> testSet;
-		std::vector<Sequence*> trainSet;
-        std::vector<Sequence*> negSet;
-		for( size_t n = 0; n <= posSeqs_.size()-cvFold_; n+=cvFold_ ){
-			for( size_t f = 0; f < cvFold_; f++ ){
-				if( f != fold ){
-					trainSet.push_back( posSeqs_[n+f] );
-				} else {
-					testSet.push_back( posSeqs_[n+f] );
-				}
-			}
-		}
-		for( size_t n = 0; n <= negSeqs_.size()-cvFold_; n+=cvFold_ ){
-            negSet.push_back( negSeqs_[n] );
-		}
-
-		/**
-		 * Training
-		 */
-		// learn motif from each training set
-		if( EMoptimize ){
-			EM model( motif, bgModel_, trainSet, optimizeQ, false, frac );
-            if( advanceEM ){
-                model.mask();
-            } else {
-                model.optimize();
-            }
-            updatedQ = model.getQ();
-		} else if ( CGSoptimize ){
-			GibbsSampling model( motif, bgModel_, trainSet, optimizeQ );
-			model.optimize();
-            updatedQ = model.getQ();
-		}
-
-		/**
-		 * Testing
-		 */
-		// score positive test sequences with (learned) motif
-		ScoreSeqSet score_testset( motif, bgModel_, testSet );
-        score_testset.calcLogOdds();
-
-        // score negative sequence set
-        ScoreSeqSet score_negset(motif, bgModel_, negSet);
-        score_negset.calcLogOdds();
-
-#pragma omp critical
-        {
-            if (mops_) {
-                mops_scores = score_testset.getMopsScores();
-
-                for (size_t n = 0; n < testSet.size(); n++) {
-                    posScoreAll_.insert(std::end(posScoreAll_),
-                                        std::begin(mops_scores[n]),
-                                        std::end(mops_scores[n]));
-                }
-
-                mops_scores.clear(); // reuse mops_scores vector
-
-                mops_scores = score_negset.getMopsScores();
-                for (size_t n = 0; n < negSet.size(); n++) {
-                    negScoreAll_.insert(std::end(negScoreAll_),
-                                        std::begin(mops_scores[n]),
-                                        std::end(mops_scores[n]));
-                }
-            }
+     * Cross validation
+     * each fold is one task: when called from within a parallel region
+     * (e.g. one task per motif), the folds join the tasks of the enclosing
+     * team; otherwise a team of perLoopThreads threads is started for them.
+     * The loops over sequences within the training and scoring of a fold
+     * are tasks of the same team, see inTaskPool() in utils.h
+     */
+    if( mops_ ){
+        posScoreAll_.resize( posAllOffset_[cvFold_] );
+        negScoreAll_.resize( cvFold_ * negAllN_ );
+    }
+    if( zoops_ ){
+        posScoreMax_.resize( posMaxOffset_[cvFold_] );
+        negScoreMax_.resize( cvFold_ * negSetN_ );
+    }
+    std::vector<float> foldQ( cvFold_, q_ );
 
-            if (zoops_) {
-                zoops_scores = score_testset.getZoopsScores();
-                posScoreMax_.insert(std::end(posScoreMax_),
-                                    std::begin(zoops_scores),
-                                    std::end(zoops_scores));
-
-                zoops_scores.clear(); // reuse zoops_scores vector
-                zoops_scores = score_negset.getZoopsScores();
-                negScoreMax_.insert(std::end(negScoreMax_),
-                                    std::begin(zoops_scores),
-                                    std::end(zoops_scores));
-            }
+    bool inParallel = false;
+#ifdef OPENMP
+    inParallel = omp_in_parallel();
+#endif
 
+    if( inParallel ){
+        for( size_t fold = 0; fold < cvFold_; fold++ ){
+#pragma omp task firstprivate( fold ) shared( foldQ )
+            foldQ[fold] = evaluateFold( fold, EMoptimize, CGSoptimize, optimizeQ, advanceEM, frac );
         }
-		if( motif ) 				delete motif;
-	}
+#pragma omp taskwait
+    } else {
+#pragma omp parallel num_threads( perLoopThreads )
+#pragma omp single
+        for( size_t fold = 0; fold < cvFold_; fold++ ){
+#pragma omp task firstprivate( fold ) shared( foldQ )
+            foldQ[fold] = evaluateFold( fold, EMoptimize, CGSoptimize, optimizeQ, advanceEM, frac );
+        }
+    }
 
-    // update Q
-    q_ = updatedQ;
+    // update Q with the one learned on the last fold
+    q_ = foldQ[cvFold_-1];
 
     // calculate precision and recall
     calculatePR();
@@ -144,19 +140,174 @@ void FDR::evaluateMotif( bool EMoptimize, bool CGSoptimize, bool optimizeQ, bool
 
 }
 
+float FDR::evaluateFold( size_t fold, bool EMoptimize, bool CGSoptimize, bool optimizeQ, bool advanceEM, float frac ){
+
+	// deep copy the initial motif
+	Motif* motif = new Motif( *motif_ );
+    float updatedQ = q_;
+
+	/**
+	 * Draw sequences for the training set
+	 */
+	std::vector<Sequence*> trainSet;
+	for( size_t n = 0; n <= posSeqs_.size()-cvFold_; n+=cvFold_ ){
+		for( size_t f = 0; f < cvFold_; f++ ){
+			if( f != fold ){
+				trainSet.push_back( posSeqs_[n+f] );
+			}
+		}
+	}
+
+	/**
+	 * Training
+	 */
+	// learn motif from each training set
+	if( EMoptimize ){
+		EM model( motif, bgModel_, trainSet, optimizeQ, false, frac );
+        if( advanceEM ){
+            model.mask();
+        } else {
+            model.optimize();
+        }
+        updatedQ = model.getQ();
+	} else if ( CGSoptimize ){
+		GibbsSampling model( motif, bgModel_, trainSet, optimizeQ );
+		model.optimize();
+        updatedQ = model.getQ();
+	}
+
+	/**
+	 * Testing
+	 */
+	// score positive test sequences and the negative set with (learned) motif,
+	// each fold writes into its own slice of the score arrays
+	ScoreSeqSet score_testset( motif, bgModel_, testSets_[fold] );
+	score_testset.calcLogOdds( mops_ ? posScoreAll_.data() + posAllOffset_[fold] : NULL,
+                               zoops_ ? posScoreMax_.data() + posMaxOffset_[fold] : NULL );
+
+	ScoreSeqSet* score_negset = ( negSource_ != NULL ) ?
+                                new ScoreSeqSet( motif, bgModel_, negSource_, cvFold_ ) :
+                                new ScoreSeqSet( motif, bgModel_, negSet_ );
+	score_negset->calcLogOdds( mops_ ? negScoreAll_.data() + fold * negAllN_ : NULL,
+                               zoops_ ? negScoreMax_.data() + fold * negSetN_ : NULL );
+	delete score_negset;
+
+	// sort the MOPS slices of this fold in ascending order, if all scores
+	// need to be ranked later on; these runs are then only merged
+	if( mops_ and ( savePvalues_ or saveLogOdds_ ) ){
+		std::sort( posScoreAll_.begin() + posAllOffset_[fold],
+				   posScoreAll_.begin() + posAllOffset_[fold+1], std::less<float>() );
+		std::sort( negScoreAll_.begin() + fold * negAllN_,
+				   negScoreAll_.begin() + ( fold+1 ) * negAllN_, std::less<float>() );
+	}
+
+	if( motif ) 				delete motif;
+
+    return updatedQ;
+}
+
 void FDR::calculatePR(){
 
 	size_t posN = posSeqs_.size();
-	size_t negN = negSeqs_.size();
+	size_t negN = negN_;
 	float mFold = ( float )negN / ( float )posN;
 
-    srand(42);
+    // local generator for breaking ties, keeps the curves independent of
+    // other motifs evaluated concurrently
+    std::mt19937 rngx( 42 );
 
 	// for MOPS model:
 	if( mops_ ){
-		// Sort log odds scores in descending order
-		std::sort( posScoreAll_.begin(), posScoreAll_.end(), std::greater<float>() );
-		std::sort( negScoreAll_.begin(), negScoreAll_.end(), std::greater<float>() );
+
+		size_t posAllN = posScoreAll_.size();
+		size_t negAllN = negScoreAll_.size();
+		size_t len_all = posAllN + negAllN;
+
+		/**
+		 * The curve is written out up to the rank where TP - FP reaches its
+		 * maximum, which for MOPS is only the top tail of all positions.
+		 * Instead of sorting all scores, they are binned (bin 0 holds the
+		 * highest scores) and TP/FP at the bin borders are obtained from
+		 * prefix sums. Within a bin, TP can at most grow by its number of
+		 * positives, so only the bins which can still reach the maximum
+		 * need to be ranked exactly.
+		 */
+		float maxScore = -FLT_MAX;
+		float minScore = FLT_MAX;
+		for( size_t i = 0; i < posAllN; i++ ){
+			maxScore = std::max( maxScore, posScoreAll_[i] );
+			minScore = std::min( minScore, posScoreAll_[i] );
+		}
+		for( size_t i = 0; i < negAllN; i++ ){
+			maxScore = std::max( maxScore, negScoreAll_[i] );
+			minScore = std::min( minScore, negScoreAll_[i] );
+		}
+		size_t B = std::max( nBins_, size_t( 1 ) );
+		float binScale = ( maxScore > minScore ) ? ( float )B / ( maxScore - minScore ) : 0.f;
+
+		// one pair of histograms per thread, see runTasks() in utils.h
+		size_t blocks = poolThreads();
+		std::vector<std::vector<size_t>> posLocal( blocks );
+		std::vector<std::vector<size_t>> negLocal( blocks );
+		runTasks( blocks, [&]( size_t t ){
+			posLocal[t].assign( B, 0 );
+			negLocal[t].assign( B, 0 );
+			for( size_t i = posAllN * t / blocks; i < posAllN * ( t+1 ) / blocks; i++ ){
+				posLocal[t][std::min( ( size_t )( ( maxScore - posScoreAll_[i] ) * binScale ), B-1 )]++;
+			}
+			for( size_t i = negAllN * t / blocks; i < negAllN * ( t+1 ) / blocks; i++ ){
+				negLocal[t][std::min( ( size_t )( ( maxScore - negScoreAll_[i] ) * binScale ), B-1 )]++;
+			}
+		} );
+		std::vector<size_t> posHist( B, 0 );
+		std::vector<size_t> negHist( B, 0 );
+		for( size_t t = 0; t < blocks; t++ ){
+			for( size_t b = 0; b < B; b++ ){
+				posHist[b] += posLocal[t][b];
+				negHist[b] += negLocal[t][b];
+			}
+		}
+
+		// lower bound for the maximal TP from the bin borders
+		float E_lower = 0.0f;
+		size_t posCum = 0;
+		size_t negCum = 0;
+		for( size_t b = 0; b < B; b++ ){
+			posCum += posHist[b];
+			negCum += negHist[b];
+			E_lower = std::max( E_lower, ( float )posCum - ( float )negCum / mFold );
+		}
+
+		// the last bin where TP can reach E_lower, and the bin which covers
+		// the default cutoff posN+negN used when the maximum is never met again
+		size_t minRank = std::min( posN + negN, len_all );
+		size_t b_cut = 0;
+		posCum = 0;
+		negCum = 0;
+		for( size_t b = 0; b < B; b++ ){
+			float TP_upper = ( float )( posCum + posHist[b] ) - ( float )negCum / mFold;
+			if( TP_upper >= E_lower || posCum + negCum < minRank ){
+				b_cut = b;
+			}
+			posCum += posHist[b];
+			negCum += negHist[b];
+		}
+
+		// rank the scores of the top bins exactly
+		std::vector<float> posTop;
+		std::vector<float> negTop;
+		for( size_t i = 0; i < posAllN; i++ ){
+			if( std::min( ( size_t )( ( maxScore - posScoreAll_[i] ) * binScale ), B-1 ) <= b_cut ){
+				posTop.push_back( posScoreAll_[i] );
+			}
+		}
+		for( size_t i = 0; i < negAllN; i++ ){
+			if( std::min( ( size_t )( ( maxScore - negScoreAll_[i] ) * binScale ), B-1 ) <= b_cut ){
+				negTop.push_back( negScoreAll_[i] );
+			}
+		}
+		parallelSort( posTop, std::greater<float>() );
+		parallelSort( negTop, std::greater<float>() );
 
 		// Rank and score these log odds score values
 		size_t idx_posAll = 0;
@@ -167,10 +318,12 @@ void FDR::calculatePR(){
 									// FP reaches maximum; otherwise, set the
 									// the number as initial cutoff
 
-		size_t len_all = posScoreAll_.size() + negScoreAll_.size();
+		size_t len_top = posTop.size() + negTop.size();
 
-		for( size_t i = 0; i < len_all; i++ ){
-			if( posScoreAll_[idx_posAll] > negScoreAll_[idx_negAll] || idx_negAll == len_all ){
+		for( size_t i = 0; i < len_top; i++ ){
+			// for equal scores, the negative is ranked first
+			if( idx_negAll == negTop.size()
+				|| ( idx_posAll < posTop.size() && posTop[idx_posAll] > negTop[idx_negAll] ) ){
 				idx_posAll++;
 			} else {
 				idx_negAll++;
@@ -181,14 +334,16 @@ void FDR::calculatePR(){
 
 			if( E_TP_MOPS == MOPS_TP_[i] ){
 				idx_max = i;
-//				break;				// stop when the distance between TFP and
-									// FP reaches maximum
 			}
 			if( E_TP_MOPS < MOPS_TP_[i] ){
 				E_TP_MOPS = MOPS_TP_[i];
 			}
 		}
 
+		idx_max = std::min( idx_max, len_top );
+		MOPS_TP_.resize( idx_max );
+		MOPS_FP_.resize( idx_max );
+
 		for( size_t i = 0; i < idx_max; i++ ){
 			MOPS_FDR_.push_back( MOPS_FP_[i] / ( MOPS_TP_[i] + MOPS_FP_[i] ) );
 			MOPS_Rec_.push_back( MOPS_TP_[i] / E_TP_MOPS );
@@ -196,15 +351,22 @@ void FDR::calculatePR(){
 
 		// the number of motif occurrences per sequence
 		occ_mult_ = E_TP_MOPS / ( float )posN;
+
+		// the log odds scores are written out in descending order
+		if( saveLogOdds_ and !savePvalues_ ){
+			mergeFoldRuns();
+			std::reverse( posScoreAll_.begin(), posScoreAll_.end() );
+			std::reverse( negScoreAll_.begin(), negScoreAll_.end() );
+		}
 	}
 
 	// for ZOOPS model:
 	if( zoops_ ){
 		PN_Pvalue_.clear();
 
-		// Sort log odds scores in descending order
-		std::sort( posScoreMax_.begin(), posScoreMax_.end(), std::greater<float>() );
-		std::sort( negScoreMax_.begin(), negScoreMax_.end(), std::greater<float>() );
+		// Sort log odds scores in descending order, tied scores stay in sequence order
+		std::stable_sort( posScoreMax_.begin(), posScoreMax_.end(), std::greater<float>() );
+		std::stable_sort( negScoreMax_.begin(), negScoreMax_.end(), std::greater<float>() );
 
 		// Rank and score these log odds score values
 		size_t idx_posMax = 0;
@@ -224,13 +386,16 @@ void FDR::calculatePR(){
 
         float Sl = 0.f;
 
-		for( size_t i = 0; i < posN + negN; i++ ){
+        size_t posMaxN = posScoreMax_.size();
+        size_t negMaxN = negScoreMax_.size();
+
+		for( size_t i = 0; i < posMaxN + negMaxN; i++ ){
 
-            if( (posScoreMax_[idx_posMax] > negScoreMax_[idx_negMax] || idx_posMax == 0 || idx_negMax == negN )
-                && idx_posMax < posN ){
+            if( idx_posMax < posMaxN
+                && ( idx_posMax == 0 || idx_negMax == negMaxN || posScoreMax_[idx_posMax] > negScoreMax_[idx_negMax] ) ){
                 Sl = posScoreMax_[idx_posMax];
                 idx_posMax++;
-            } else if( posScoreMax_[idx_posMax] == negScoreMax_[idx_negMax] && rand() % 2 == 0 && idx_posMax < posN ){
+            } else if( idx_posMax < posMaxN && posScoreMax_[idx_posMax] == negScoreMax_[idx_negMax] && rngx() % 2 == 0 ){
                 Sl = posScoreMax_[idx_posMax];
                 idx_posMax++;
             } else {
@@ -249,7 +414,8 @@ void FDR::calculatePR(){
             if( Sl <= negScoreMax_[n_top] ){
 
                 float Sl_upper = *(std::lower_bound( negScoreMax_.begin(), negScoreMax_.end(), Sl, std::greater<float>() )-1);
-                float Sl_lower = *std::upper_bound( negScoreMax_.begin(), negScoreMax_.end(), Sl, std::greater<float>() );
+                std::vector<float>::iterator it_lower = std::upper_bound( negScoreMax_.begin(), negScoreMax_.end(), Sl, std::greater<float>() );
+                float Sl_lower = ( it_lower != negScoreMax_.end() ) ? *it_lower : negScoreMax_.back();
                 p_value = ( idx_negMax + ( Sl_upper- Sl) / (Sl_upper - Sl_lower + 1e-5)) / (float)negN;
 
             } else {
@@ -285,9 +451,9 @@ void FDR::calculatePvalues(){
     // for MOPS model:
     if( mops_ ){
         // Sort log odds scores in ascending order
-        std::sort( negScoreAll_.begin(), negScoreAll_.end(), std::less<float>() );
-        std::sort( posScoreAll_.begin(), posScoreAll_.end(), std::less<float>() );
-        for( size_t i = 0; i < posScoreAll_.size(); i++ ){
+        mergeFoldRuns();
+        MOPS_Pvalue_.resize( posScoreAll_.size() );
+        parallelFor( posScoreAll_.size(), [&]( size_t i ){
             // Return iterator to lower/upper bound
             size_t low, up;
             low = std::distance( negScoreAll_.begin(),
@@ -302,15 +468,15 @@ void FDR::calculatePvalues(){
             // avoid the rounding errors, such as p-value = 0 or p-value > 1
             if( p < 1.e-6 ) p = 1.e-6;
             if( p > 1.0f )  p = 1.0f;
-            MOPS_Pvalue_.push_back( p );
-        }
+            MOPS_Pvalue_[i] = p;
+        } );
     }
 
     // for ZOOPS model:
     if( zoops_ ){
-        // Sort log odds scores in ascending order
-        std::sort( negScoreMax_.begin(), negScoreMax_.end(), std::less<float>() );
-        std::sort( posScoreMax_.begin(), posScoreMax_.end(), std::less<float>() );
+        // Sort log odds scores in ascending order, tied scores stay in sequence order
+        std::stable_sort( negScoreMax_.begin(), negScoreMax_.end(), std::less<float>() );
+        std::stable_sort( posScoreMax_.begin(), posScoreMax_.end(), std::less<float>() );
         for( size_t i = 0; i < posScoreMax_.size(); i++ ){
             // Return iterator to lower/upper bound
             size_t low, up;
@@ -331,6 +497,17 @@ void FDR::calculatePvalues(){
     }
 }
 
+void FDR::mergeFoldRuns(){
+
+	std::vector<size_t> posBounds( posAllOffset_ );
+	std::vector<size_t> negBounds;
+	for( size_t f = 0; f <= cvFold_; f++ ){
+		negBounds.push_back( f * negAllN_ );
+	}
+	mergeSortedRuns( posScoreAll_, posBounds, std::less<float>() );
+	mergeSortedRuns( negScoreAll_, negBounds, std::less<float>() );
+}
+
 void FDR::print(){
 
 }
@@ -358,7 +535,7 @@ void FDR::write( char* odir, std::string basename ){
 						<< "FDR" 	<< '\t'
 						<< "Recall"	<< '\t'
 						<< "p-value"<< '\t'
-						<< ( float )negSeqs_.size() / ( float )posSeqs_.size() << '\t'
+						<< ( float )negN_ / ( float )posSeqs_.size() << '\t'
                         << occ_frac_ << std::endl;
 
 			for( size_t i = 0; i < ZOOPS_FDR_.size(); i++ ){
@@ -429,7 +606,7 @@ void FDR::write( char* odir, std::string basename ){
 			for( size_t i = 0; i < posScoreMax_.size(); i++ ){
 				ofile_zoops_logOdds	<< std::setprecision( 6 )
 									<< posScoreMax_[i] << '\t'
-									<< negScoreMax_[i*negSeqs_.size()/posSeqs_.size()]
+									<< negScoreMax_[i*negN_/posSeqs_.size()]
 									<< std::endl;
 			}
 		}
@@ -442,7 +619,7 @@ void FDR::write( char* odir, std::string basename ){
 			for( size_t i = 0; i < posScoreAll_.size(); i++ ){
 				ofile_mops_logOdds 	<< std::setprecision( 6 )
 									<< posScoreAll_[i] << '\t'
-									<< negScoreAll_[i*negSeqs_.size()/posSeqs_.size()]
+									<< negScoreAll_[i*negN_/posSeqs_.size()]
 									<< std::endl;
 			}
 		}
@@ -27,7 +27,15 @@ public:
 	FDR( std::vector<Sequence*> posSeqs, std::vector<Sequence*> negSeqs,
          Motif* motif = NULL, BackgroundModel* bgmodel = NULL,
          size_t cvFold = 4, bool mops = false, bool zoops = true,
-         bool savePRs = true, bool savePvalues = false, bool saveLogOdds = false
+         bool savePRs = true, bool savePvalues = false, bool saveLogOdds = false,
+         size_t nBins = 65536
+        );
+	// the negative set is generated on demand instead of being held in memory
+	FDR( std::vector<Sequence*> posSeqs, SeqSource* negSource,
+         Motif* motif = NULL, BackgroundModel* bgmodel = NULL,
+         size_t cvFold = 4, bool mops = false, bool zoops = true,
+         bool savePRs = true, bool savePvalues = false, bool saveLogOdds = false,
+         size_t nBins = 65536
         );
 	~FDR();
 
@@ -43,8 +51,14 @@ public:
 
 private:
 
+	FDR( std::vector<Sequence*> posSeqs, std::vector<Sequence*> negSeqs, SeqSource* negSource,
+         Motif* motif, BackgroundModel* bgmodel, size_t cvFold, bool mops, bool zoops,
+         bool savePRs, bool savePvalues, bool saveLogOdds, size_t nBins );
+
 	std::vector<Sequence*> posSeqs_;
 	std::vector<Sequence*> negSeqs_;
+	SeqSource*			negSource_;		// generated negative set, replaces negSeqs_ if given
+	size_t				negN_;			// number of negative sequences
 	float q_;
 
 	Motif*				motif_;			// initial motif
@@ -57,12 +71,20 @@ private:
 	bool				savePRs_;
 	bool				savePvalues_;
 	bool				saveLogOdds_;
+	size_t				nBins_;			// number of score bins for ranking MOPS scores
 
 	std::vector<float> 	posScoreAll_;	// store log odds scores over all positions on the sequences
 	std::vector<float> 	posScoreMax_;	// store maximal log odds score from each sequence
 	std::vector<float> 	negScoreAll_;
 	std::vector<float> 	negScoreMax_;
 
+	std::vector<std::vector<Sequence*>>	testSets_;	// test set of each cross-validation fold
+	std::vector<Sequence*>	negSet_;		// negative sequences scored in each fold
+	size_t				negSetN_;		// number of negative sequences scored in each fold
+	std::vector<size_t>	posAllOffset_;	// offsets of the folds in posScoreAll_
+	std::vector<size_t>	posMaxOffset_;	// offsets of the folds in posScoreMax_
+	size_t				negAllN_;		// number of positions of negSet_ per fold
+
 	std::vector<float>	ZOOPS_FDR_;		// precision for ZOOPS model
 	std::vector<float>	ZOOPS_Rec_;		// recall for ZOOPS model
 	std::vector<float>  ZOOPS_TP_;		// true positives for ZOOPS model
@@ -82,9 +104,17 @@ private:
 	std::vector<float>	ZOOPS_Pvalue_;	// p-values for scores from positive set with ZOOPS model
 	std::vector<float>	MOPS_Pvalue_;	// p-values for scores from positive set with MOPS model
 
+			// train on one cross-validation fold and score its test and negative sets,
+			// returns the optimized q
+	float	evaluateFold( size_t fold, bool EMoptimize, bool CGSoptimize,
+                          bool optimizeQ, bool advanceEM, float frac );
+
 			// calculate precision and recall for both ZOOPS and MOPS init
 	void 	calculatePR();
 
+			// merge the ascendingly sorted MOPS score slices of all folds
+	void	mergeFoldRuns();
+
 			// calculate P-values for log odds scores of positive sequences
 	void	calculatePvalues();
 
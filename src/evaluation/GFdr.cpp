@@ -23,6 +23,7 @@ char*               GFdr::negSequenceFilename = NULL;	// filename of negative se
 SequenceSet*        GFdr::negSequenceSet = NULL;		// negative sequence set
 bool                GFdr::B3 = false;                   // whether or not to take the given negative sequences for evaluation
 bool                GFdr::genericNeg = false;           // flag for generating negative sequences based on generic 2nd-bgModel
+bool                GFdr::kShuffle = false;             // flag for generating negative sequences by shuffling the positive sequences
 
 // alphabet options
 char*			    GFdr::alphabetType = NULL;			// alphabet type is defaulted to standard which is ACGT
@@ -46,6 +47,7 @@ bool                GFdr::interpolateBG = true;			// calculate prior probabiliti
                                                         // instead of background frequencies of mononucleotides
 // background model options
 char*               GFdr::bgModelFilename = NULL;       // filename of background model in BaMM format (.hbcp/.hbp)
+char*               GFdr::bgModelStore = NULL;          // directory of the background k-mer count store
 size_t			    GFdr::bgModelOrder = 2;				// background model order, defaults to 2
 std::vector<float>  GFdr::bgModelAlpha( bgModelOrder+1, 1.f );// background model alpha
 
@@ -59,6 +61,7 @@ size_t              GFdr::negN = 5000;                  // number of negative se
 bool                GFdr::fixedNegN = false;            // flag for using fixed number of negative sequences
 size_t		        GFdr::cvFold = 4;					// number of cross-validation (cv) folds
 size_t		        GFdr::sOrder = 2;					// k-mer order for sampling negative sequence set
+size_t              GFdr::PRbins = 65536;               // number of score bins for ranking MOPS scores
 
 // printout options
 bool			    GFdr::savePvalues = false;			// write p-values for each log odds score from sequence set
@@ -66,7 +69,7 @@ bool			    GFdr::saveLogOdds = false;			// write the log odds of positive and ne
 
 // option for openMP
 size_t              GFdr::threads = 4;                  // number of threads to use
-bool                GFdr::parallel_motif = false;       // flag for parallelizing over motifs
+bool                GFdr::parallel_motif = false;       // obsolete: motifs and folds are scheduled as tasks
 
 void GFdr::init( int nargs, char* args[] ){
 
@@ -219,6 +222,13 @@ int GFdr::readArguments( int nargs, char* args[] ){
                 exit( 2 );
             }
             bgModelFilename = args[i];
+        } else if( !strcmp( args[i], "--bgModelStore" ) ){
+            if( ++i >= nargs ){
+                printHelp();
+                std::cerr << "No expression following --bgModelStore" << std::endl;
+                exit( 2 );
+            }
+            bgModelStore = args[i];
         } else if( !strcmp( args[i], "-K" ) or !strcmp( args[i], "--Order" ) ){
             if( ++i >= nargs ){
                 printHelp();
@@ -258,6 +268,8 @@ int GFdr::readArguments( int nargs, char* args[] ){
             fixedNegN = true;
         } else if( !strcmp( args[i], "--genericNeg" ) ){
             genericNeg = true;
+        } else if( !strcmp( args[i], "--kShuffle" ) ){
+            kShuffle = true;
         } else if( !strcmp( args[i], "--cvFold" ) ){
             if( ++i >= nargs ){
                 printHelp();
@@ -272,6 +284,19 @@ int GFdr::readArguments( int nargs, char* args[] ){
                 exit( 2 );
             }
             sOrder = std::stoi( args[i] );
+        } else if( !strcmp( args[i], "--PRbins" ) ){
+            if( ++i >= nargs ){
+                printHelp();
+                std::cerr << "No expression following --PRbins" << std::endl;
+                exit( 2 );
+            }
+            char* end;
+            long bins = strtol( args[i], &end, 10 );
+            if( end == args[i] or *end != '\0' or bins < 1 ){
+                std::cerr << "Error: --PRbins takes a positive number of bins." << std::endl;
+                exit( 2 );
+            }
+            PRbins = ( size_t )bins;
         } else if( !strcmp( args[i], "--savePvalues" ) ){
             savePvalues = true;
         } else if( !strcmp( args[i], "--saveLogOdds" ) ){
@@ -361,6 +386,11 @@ void GFdr::printHelp(){
                    "				to learn the (homogeneous) background BaMM.\n"
                    "				If not specified, the background BaMM is learned\n"
                    "				from the positive sequences. \n\n");
+    printf("\n			--kShuffle \n"
+                   "				Generate the negative sequences by shuffling the\n"
+                   "				positive sequences, preserving their (s+1)-mer counts\n"
+                   "				exactly, with s given by --sOrder. By default, they\n"
+                   "				are sampled from the s-th order k-mer model.\n\n");
     printf("\n		Options for initialize BaMM(s) from file: \n");
     printf("\n 			--bindingSiteFile <STRING> \n"
                    "				File with binding sites of equal length(one per line).\n\n");
@@ -403,6 +433,11 @@ void GFdr::printHelp(){
                    "				Order. The default is 2.\n"
                    "				Order of background model should not exceed order of\n"
                    "				motif model.\n\n");
+    printf("\n 			--bgModelStore <STRING> \n"
+                   "				Directory of stored background k-mer counts. The counts\n"
+                   "				of a sequence set are read from here if they were stored\n"
+                   "				before with the same or a higher order, and are stored\n"
+                   "				here otherwise. Defaults to NULL.\n\n");
     printf("\n 		Options for optimization: \n");
     printf("\n 			--EM  \n"
                    "				Triggers Expectation Maximization (EM) algorithm.\n "
@@ -414,6 +449,10 @@ void GFdr::printHelp(){
     printf("\n 			--savePRs\n"
                    "				Write true positives(TP), false positives(FP), \n"
                    "				FDR and recall values to disk. Defaults to true.\n\n");
+    printf("\n 			--PRbins <INTEGER>\n"
+                   "				Number of bins for ranking the MOPS log odds scores.\n"
+                   "				Only the bins up to the maximum of TP - FP are\n"
+                   "				sorted exactly. Defaults to 65536.\n\n");
     printf("\n 			--savePvalues\n"
                    "				Write p-values for plotting area under the \n"
                    "				Sensitivity-FDR curve (AUSFC) to disk.\n\n");
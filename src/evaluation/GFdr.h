@@ -30,6 +30,7 @@ public:
     static char* 		alphabetType;			// provide alphabet type
     static bool         B3;                     // whether or not to take the given negative sequences for evaluation
     static bool         genericNeg;             // flag for generating negative sequences based on generic 2nd-bgModel
+    static bool         kShuffle;               // flag for generating negative sequences by shuffling the positive sequences
 
     // initial model(s) options
     static char*		initialModelFilename;	// filename of initial model
@@ -51,6 +52,7 @@ public:
 
     // background model options
     static char*		bgModelFilename;	    // filename of background model in BaMM format (.hbcp/.hbp)
+    static char*		bgModelStore;			// directory of the background k-mer count store
     static size_t		bgModelOrder;			// background model order, defaults to 2
     static std::vector<float> bgModelAlpha;		// background model alpha
 
@@ -64,6 +66,7 @@ public:
     static bool         fixedNegN;              // flag for using fixed number of negative sequences
 	static size_t		cvFold;					// number of cross-validation (cv) folds
 	static size_t		sOrder;					// k-mer order for sampling negative sequence set
+    static size_t       PRbins;                 // number of score bins for ranking MOPS scores
 
     // other options
     static bool			savePvalues;			// write p-values for each log odds score from sequence set
@@ -71,7 +74,7 @@ public:
 
     // option for openMP
     static size_t       threads;                // number of threads to use
-    static bool         parallel_motif;         // flag for parallelizing over motifs
+    static bool         parallel_motif;         // obsolete: motifs and folds are scheduled as tasks
 
     static void         init( int nargs, char* args[] );
     static void         destruct();
@@ -2,8 +2,13 @@
 // Created by wanwan on 03.09.17.
 //
 
+#ifdef OPENMP
+#include <omp.h>
+#endif
+
 #include "GFdr.h"
 #include "FDR.h"
+#include "../seq_generator/BgSeqSource.h"
 #include "../refinement/Global.h"
 
 int main( int nargs, char* args[] ){
@@ -23,7 +28,9 @@ int main( int nargs, char* args[] ){
                                       GFdr::bgModelOrder,
                                       GFdr::bgModelAlpha,
                                       GFdr::interpolateBG,
-                                      GFdr::outputFileBasename);
+                                      GFdr::outputFileBasename,
+                                      GFdr::bgModelStore,
+                                      GFdr::posSequenceSet->getHash() );
     } else {
         bgModel = new BackgroundModel( GFdr::bgModelFilename );
     }
@@ -85,81 +92,81 @@ int main( int nargs, char* args[] ){
      * Generate negative sequence set for cross-validation
      */
     std::vector<Sequence*>  negset;
+    SeqGenerator* negseq = NULL;
+    BgSeqSource* negSource = NULL;
     if( GFdr::B3 ){
         // take the given negative sequence set
         negset = GFdr::negSequenceSet->getSequences();
 
     } else {
         // generate negative sequence set based on s-mer frequencies
-        // from positive training sequence set
+        // from positive training sequence set; the sequences are only
+        // generated when they are scored
         posN = posSet.size();   // update the size of positive sequences after filtering
-        std::vector<std::unique_ptr<Sequence>> negSeqs;
-        SeqGenerator negseq( posSet, NULL, GFdr::sOrder , GFdr::genericNeg );
+        negseq = new SeqGenerator( posSet, NULL, GFdr::sOrder, 1.0f, GFdr::genericNeg, GFdr::kShuffle );
         if( !GFdr::fixedNegN and posN >= GFdr::negN ){
-            negSeqs = negseq.sample_bgseqset_by_fold( GFdr::mFold );
+            negSource = new BgSeqSource( negseq, GFdr::mFold );
             std::cout << GFdr::mFold << " x " << posN << " background sequences are generated." << std::endl;
         } else if( !GFdr::fixedNegN and posN < GFdr::negN ){
             bool rest = GFdr::negN % posSet.size();
             GFdr::mFold = GFdr::negN / posN + rest;
-            negSeqs = negseq.sample_bgseqset_by_fold( GFdr::mFold );
+            negSource = new BgSeqSource( negseq, GFdr::mFold );
             std::cout << GFdr::mFold << " x " << posN << " background sequences are generated." << std::endl;
         } else {
-            negSeqs = negseq.sample_bgseqset_by_num( GFdr::negN, GFdr::posSequenceSet->getMaxL() );
+            negSource = new BgSeqSource( negseq, GFdr::negN, GFdr::posSequenceSet->getMaxL() );
             std::cout << GFdr::negN << " (fixed) background sequences are generated." << std::endl;
         }
-        // convert unique_ptr to regular pointer
-        for (size_t n = 0; n < negSeqs.size(); n++) {
-            negset.push_back(negSeqs[n].release());
-            negSeqs[n].get_deleter();
-        }
     }
 
     /**
-     * Cross-validate the motif model
+     * Cross-validate the motif models
+     * each motif is a task which spawns one task per fold, all of them
+     * share the threads of a single team; the loops over sequences within
+     * EM and the scoring of a fold are tasks of this team as well
      */
-    size_t mainLoopThreads;
-    size_t perLoopThreads;
-    if( GFdr::parallel_motif ){
-        mainLoopThreads = GFdr::threads;
-        perLoopThreads = 1;
-    } else {
-        mainLoopThreads = 1;
-        perLoopThreads = GFdr::threads;
-    }
-
-#pragma omp parallel for num_threads( mainLoopThreads )
-
+#pragma omp parallel num_threads( GFdr::threads )
+#pragma omp single
     for( size_t n = 0; n < motif_set.getN(); n++ ){
-
-        Motif* motif = new Motif( *motif_set.getMotifs()[n] );
-
-        FDR fdr( posSet, negset,
-                 motif, bgModel,
-                 GFdr::cvFold, GFdr::mops, GFdr::zoops,
-                 true, GFdr::savePvalues, GFdr::saveLogOdds );
-
-        fdr.evaluateMotif( GFdr::EM, GFdr::CGS, false, false, 0.05f, perLoopThreads );
-
-        if(GFdr::saveInitialModel){
-            // write out the foreground model
-            motif->write( GFdr::outputDirectory,
-                          GFdr::outputFileBasename + "_init_motif_" + std::to_string( n+1 ) );
-
+#pragma omp task firstprivate( n )
+        {
+            Motif* motif = new Motif( *motif_set.getMotifs()[n] );
+
+            FDR* fdr;
+            if( negSource != NULL ){
+                fdr = new FDR( posSet, negSource,
+                               motif, bgModel,
+                               GFdr::cvFold, GFdr::mops, GFdr::zoops,
+                               true, GFdr::savePvalues, GFdr::saveLogOdds, GFdr::PRbins );
+            } else {
+                fdr = new FDR( posSet, negset,
+                               motif, bgModel,
+                               GFdr::cvFold, GFdr::mops, GFdr::zoops,
+                               true, GFdr::savePvalues, GFdr::saveLogOdds, GFdr::PRbins );
+            }
+
+            fdr->evaluateMotif( GFdr::EM, GFdr::CGS, false, false, 0.05f, GFdr::threads );
+
+            if(GFdr::saveInitialModel){
+                // write out the foreground model
+                motif->write( GFdr::outputDirectory,
+                              GFdr::outputFileBasename + "_init_motif_" + std::to_string( n+1 ) );
+
+            }
+
+            std::string fileExtension;
+            if( GFdr::initialModelTag == "PWM" ) {
+                fileExtension = "_motif_" + std::to_string(n + 1);
+            }
+
+            fdr->write( GFdr::outputDirectory,
+                        GFdr::outputFileBasename + fileExtension );
+            delete fdr;
+            if( motif )		delete motif;
         }
-
-        std::string fileExtension;
-        if( GFdr::initialModelTag == "PWM" ) {
-            fileExtension = "_motif_" + std::to_string(n + 1);
-        }
-
-        fdr.write( GFdr::outputDirectory,
-                   GFdr::outputFileBasename + fileExtension );
-        if( motif )		delete motif;
     }
 
-    for (size_t n = 0; n < negset.size(); n++) {
-        if( !GFdr::B3 and negset[n] ) delete negset[n];
-    }
+    if( negSource ) delete negSource;
+    if( negseq ) delete negseq;
 
     // free memory
     if( bgModel ) delete bgModel;
@@ -80,3 +80,13 @@ char* Alphabet::getAlphabet(){
 size_t Alphabet::getSize(){
 	return size_;
 }
+
+size_t Alphabet::getRevCompKmer( size_t y, size_t k ){
+	// the complement of the last letter of y becomes the first letter
+	size_t rc = 0;
+	for( size_t i = 0; i < k; i++ ){
+		rc = rc * size_ + getComplementCode( uint8_t( y % size_ + 1 ) ) - 1;
+		y /= size_;
+	}
+	return rc;
+}
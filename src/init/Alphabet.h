@@ -21,6 +21,7 @@ public:
 	static uint8_t	getCode( char base );				// get encoding for base
 	static char		getBase( uint8_t code );			// get base from encoding
 	static uint8_t	getComplementCode( uint8_t code );	// get complement encoding from encoding
+	static size_t	getRevCompKmer( size_t y, size_t k );	// get the reverse complement of the k-mer value y
 
 private:
 
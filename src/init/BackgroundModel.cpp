@@ -4,7 +4,10 @@ BackgroundModel::BackgroundModel( std::vector<Sequence*> seqs,
 									size_t order,
 									std::vector<float> alpha,
 									bool interpolate,
-									std::string basename ){
+									std::string basename,
+									char* storeDir,
+									uint64_t storeKey,
+									bool revComp ){
 
 	basename_ = basename;
 	K_ = order;
@@ -22,22 +25,31 @@ BackgroundModel::BackgroundModel( std::vector<Sequence*> seqs,
         v_[k] = ( float* )calloc( Y_[k+1], sizeof( float ) );
 	}
 
-	// calculate counts
-	for( size_t s_idx = 0; s_idx < seqs.size(); s_idx++ ){
-		// get sequence length
-		size_t L = seqs[s_idx]->getL();
+	// calculate counts for the highest order K, or read them from the store
+	if( storeDir != NULL ){
+		char name[32];
+		snprintf( name, sizeof( name ), "%016llx.bgcounts", ( unsigned long long )storeKey );
+		std::string filePath = std::string( storeDir ) + '/' + name;
+		if( !readCounts( filePath, storeKey ) ){
+			countKmers( seqs );
+			writeCounts( storeDir, filePath, storeKey );
+		}
+	} else {
+		countKmers( seqs );
+	}
 
-		size_t* kmer = seqs[s_idx]->getKmer();
+	// add the counts of the reverse strands, for sequences stored without them
+	if( revComp ){
+		std::vector<size_t> n( n_[K_], n_[K_] + Y_[K_+1] );
+		for( size_t y = 0; y < Y_[K_+1]; y++ ){
+			n_[K_][y] += n[Alphabet::getRevCompKmer( y, K_+1 )];
+		}
+	}
 
-		// loop over sequence positions
-		for( size_t i = 0; i < L; i++ ){
-			// loop over order
-			for( size_t k = 0; k <= K_; k++ ){
-				// extract (k+1)mer
-				size_t y = kmer[i] % Y_[k+1];
-				// count (k+1)mer
-				n_[k][y]++;
-			}
+	// calculate counts from higher to lower order
+	for( size_t k = K_; k > 0; k-- ){
+		for( size_t y = 0; y < Y_[k+1]; y++ ){
+			n_[k-1][y % Y_[k]] += n_[k][y];
 		}
 	}
 
@@ -45,6 +57,140 @@ BackgroundModel::BackgroundModel( std::vector<Sequence*> seqs,
 	calculateV();
 }
 
+// count the (K+1)-mers into per-thread tables and sum these up into n_[K_]
+void BackgroundModel::countKmers( std::vector<Sequence*> seqs ){
+
+	// split the sequences into chunks of positions, such that also a few
+	// long sequences, e.g. chromosomes, are spread over the threads
+	size_t chunkSize = 1 << 16;
+	std::vector<std::pair<size_t, size_t>> chunks;
+	for( size_t s_idx = 0; s_idx < seqs.size(); s_idx++ ){
+		for( size_t start = 0; start < seqs[s_idx]->getL(); start += chunkSize ){
+			chunks.push_back( std::make_pair( s_idx, start ) );
+		}
+	}
+
+	size_t threads = 1;
+#ifdef OPENMP
+	threads = omp_get_max_threads();
+#endif
+	// the first thread counts into n_[K_] directly
+	std::vector<size_t*> counts( threads, NULL );
+	counts[0] = n_[K_];
+
+#pragma omp parallel num_threads( threads )
+	{
+		size_t t = 0;
+#ifdef OPENMP
+		t = omp_get_thread_num();
+#endif
+		if( t > 0 ){
+			counts[t] = ( size_t* )calloc( Y_[K_+1], sizeof( size_t ) );
+		}
+		size_t* n = counts[t];
+
+#pragma omp for schedule( dynamic )
+		for( size_t c = 0; c < chunks.size(); c++ ){
+			size_t* kmer = seqs[chunks[c].first]->getKmer();
+			size_t end = std::min( chunks[c].second + chunkSize, seqs[chunks[c].first]->getL() );
+			// loop over sequence positions
+			for( size_t i = chunks[c].second; i < end; i++ ){
+				// count (K+1)mer
+				n[kmer[i] % Y_[K_+1]]++;
+			}
+		}
+
+		// sum up the per-thread counts, each thread over a range of (K+1)-mers
+#pragma omp for
+		for( size_t y = 0; y < Y_[K_+1]; y++ ){
+			for( size_t u = 1; u < threads; u++ ){
+				if( counts[u] != NULL ){
+					n_[K_][y] += counts[u][y];
+				}
+			}
+		}
+	}
+
+	for( size_t u = 1; u < threads; u++ ){
+		free( counts[u] );
+	}
+}
+
+/**
+ * binary count store:
+ * "BaMMbgc" and a format version byte
+ * uint64_t	hash of the sequence set
+ * uint64_t	alphabet size
+ * uint64_t	order K
+ * uint64_t	(K+1)-mer counts for K+1 = 1, ..., alphabet size^(K+1)
+ */
+static const char	countStoreMagic[8] = { 'B', 'a', 'M', 'M', 'b', 'g', 'c', 1 };
+
+// read the counts into n_[K_] if the store holds counts of order K_ or higher
+bool BackgroundModel::readCounts( std::string filePath, uint64_t hash ){
+
+	FILE* file = fopen( filePath.c_str(), "rb" );
+	if( file == NULL ){
+		return false;
+	}
+
+	char magic[8];
+	uint64_t header[3];
+	if( fread( magic, 1, 8, file ) != 8 or memcmp( magic, countStoreMagic, 8 ) != 0
+		or fread( header, sizeof( uint64_t ), 3, file ) != 3
+		or header[0] != hash or header[1] != Y_[1] or header[2] < K_ or header[2] > 10 ){
+		fclose( file );
+		return false;
+	}
+
+	// sum up the counts of the stored order over the letters before the (K+1)-mers
+	size_t Y = ipow( Y_[1], header[2]+1 );
+	uint64_t* counts = ( uint64_t* )malloc( Y * sizeof( uint64_t ) );
+	bool complete = ( fread( counts, sizeof( uint64_t ), Y, file ) == Y );
+	fclose( file );
+
+	if( complete ){
+		for( size_t y = 0; y < Y; y++ ){
+			n_[K_][y % Y_[K_+1]] += counts[y];
+		}
+	}
+	free( counts );
+
+	return complete;
+}
+
+// the store only saves work: the run goes on with the counted model if it cannot be written
+void BackgroundModel::writeCounts( char* storeDir, std::string filePath, uint64_t hash ){
+
+	struct stat sb;
+	if( stat( storeDir, &sb ) != 0 ){
+		if( system( ( "mkdir -p " + std::string( storeDir ) ).c_str() ) != 0 ){
+			std::cerr << "Warning: Cannot create background model store: "
+					<< storeDir << std::endl;
+			return;
+		}
+	}
+
+	// write to a temporary file first, such that concurrent runs never read a partial store
+	std::string tmpPath = filePath + ".tmp" + std::to_string( getpid() );
+	FILE* file = fopen( tmpPath.c_str(), "wb" );
+
+	uint64_t header[3] = { hash, Y_[1], K_ };
+	std::vector<uint64_t> counts( n_[K_], n_[K_] + Y_[K_+1] );
+	bool written = ( file != NULL
+					and fwrite( countStoreMagic, 1, 8, file ) == 8
+					and fwrite( header, sizeof( uint64_t ), 3, file ) == 3
+					and fwrite( counts.data(), sizeof( uint64_t ), counts.size(), file ) == counts.size() );
+	if( file != NULL and fclose( file ) != 0 ){
+		written = false;
+	}
+	if( !written or rename( tmpPath.c_str(), filePath.c_str() ) != 0 ){
+		std::cerr << "Warning: Cannot write background model store: "
+				<< filePath << std::endl;
+		remove( tmpPath.c_str() );
+	}
+}
+
 BackgroundModel::BackgroundModel( std::string filePath ){
 
 	basename_ = baseName( filePath.c_str() );
@@ -258,12 +404,17 @@ double BackgroundModel::calculateLogLikelihood( std::vector<Sequence*> seqs ){
 }
 
 void BackgroundModel::calculatePosLikelihoods( std::vector<Sequence*> seqs,
-		                                       char* odir ){
+		                                       char* odir, std::string format ){
 
 	if( vIsLog_ ){
 		expV();
 	}
 
+	if( format != "text" ){
+		writePosLikelihoods( seqs, odir, format );
+		return;
+	}
+
 	std::ofstream file( std::string( odir ) + '/'
 			            + basename_ + '_' + ".lhs" );
 
@@ -295,6 +446,112 @@ void BackgroundModel::calculatePosLikelihoods( std::vector<Sequence*> seqs,
 	}
 }
 
+/**
+ * binary positional likelihoods (.lhb), little-endian:
+ * "BaMMlhb" and a format version byte
+ * uint32_t	value type: 0 float32, 1 float16, 2 dictionary index
+ * uint32_t	bytes per value: 4, 2, or 1, 2, 4 for dictionary indices
+ * uint64_t	number of sequences N
+ * uint64_t	number of dictionary entries D, 0 unless value type 2
+ * float	dictionary: v[k][y] for k = 0, ..., K and all y, in this order
+ * uint64_t	N+1 offsets, sequence n holds the values offsets[n], ..., offsets[n+1]-1
+ * values of all positions of all sequences
+ */
+void BackgroundModel::writePosLikelihoods( std::vector<Sequence*> seqs, char* odir, std::string format ){
+
+	uint32_t type, bytes;
+	uint64_t D = 0;
+	if( format == "float32" ){
+		type = 0;
+		bytes = 4;
+	} else if( format == "float16" ){
+		type = 1;
+		bytes = 2;
+	} else if( format == "dict" ){
+		type = 2;
+		for( size_t k = 0; k <= K_; k++ ){
+			D += Y_[k+1];
+		}
+		bytes = ( D <= 0x100 ) ? 1 : ( D <= 0x10000 ) ? 2 : 4;
+	} else {
+		std::cerr << "Error: Unknown format of positional likelihoods: "
+				<< format << std::endl;
+		exit( 1 );
+	}
+
+	std::string filePath = std::string( odir ) + '/' + basename_ + '_' + ".lhb";
+	FILE* file = fopen( filePath.c_str(), "wb" );
+	if( file == NULL ){
+		std::cerr << "Error: Cannot write into output directory: "
+				<< odir << std::endl;
+		exit( 1 );
+	}
+
+	char magic[8] = { 'B', 'a', 'M', 'M', 'l', 'h', 'b', 1 };
+	uint64_t N = seqs.size();
+	std::vector<uint64_t> offsets( N+1, 0 );
+	for( size_t n = 0; n < N; n++ ){
+		offsets[n+1] = offsets[n] + seqs[n]->getL();
+	}
+	// start of the entries of order k in the dictionary
+	std::vector<uint32_t> first( K_+1, 0 );
+	std::vector<float> dict;
+	if( type == 2 ){
+		for( size_t k = 0; k <= K_; k++ ){
+			first[k] = static_cast<uint32_t>( dict.size() );
+			dict.insert( dict.end(), v_[k], v_[k] + Y_[k+1] );
+		}
+	}
+
+	bool ok = fwrite( magic, 1, 8, file ) == 8
+			and fwrite( &type, sizeof( uint32_t ), 1, file ) == 1
+			and fwrite( &bytes, sizeof( uint32_t ), 1, file ) == 1
+			and fwrite( &N, sizeof( uint64_t ), 1, file ) == 1
+			and fwrite( &D, sizeof( uint64_t ), 1, file ) == 1
+			and fwrite( dict.data(), sizeof( float ), dict.size(), file ) == dict.size()
+			and fwrite( offsets.data(), sizeof( uint64_t ), N+1, file ) == N+1;
+
+	// the values are written in chunks
+	std::vector<uint8_t> buffer( 1 << 20 );
+	size_t used = 0;
+
+	for( size_t s_idx = 0; ok and s_idx < N; s_idx++ ){
+		// get sequence length
+		size_t L = seqs[s_idx]->getL();
+		size_t* kmer = seqs[s_idx]->getKmer();
+		// loop over sequence positions
+		for( size_t i = 0; i < L; i++ ){
+			// calculate k
+			size_t k = std::min( i, K_ );
+			// extract (k+1)mer
+			size_t y = kmer[i] % Y_[k+1];
+
+			if( used + bytes > buffer.size() ){
+				ok = ok and fwrite( buffer.data(), 1, used, file ) == used;
+				used = 0;
+			}
+			uint8_t* p = buffer.data() + used;
+			if( type == 0 ){
+				memcpy( p, &v_[k][y], 4 );
+			} else if( type == 1 ){
+				uint16_t h = floatToHalf( v_[k][y] );
+				memcpy( p, &h, 2 );
+			} else {
+				uint32_t idx = first[k] + static_cast<uint32_t>( y );
+				memcpy( p, &idx, bytes );
+			}
+			used += bytes;
+		}
+	}
+	ok = ok and fwrite( buffer.data(), 1, used, file ) == used;
+
+	if( fclose( file ) != 0 or !ok ){
+		std::cerr << "Error: Cannot write into output directory: "
+				<< odir << std::endl;
+		exit( 1 );
+	}
+}
+
 void BackgroundModel::print(){
 
 	if( interpolate_ ){
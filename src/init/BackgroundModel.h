@@ -10,6 +10,9 @@
 
 #include <sys/stat.h>
 #include <math.h>	// e.g. logf
+#include <stdint.h>	// e.g. uint64_t
+#include <string.h>	// e.g. memcmp
+#include <unistd.h>	// e.g. getpid
 
 #include "Alphabet.h"
 #include "SequenceSet.h"
@@ -23,7 +26,10 @@ public:
 					size_t order,
 			        std::vector<float> alpha,
 			        bool interpolate = true,
-					std::string basename = "" );
+					std::string basename = "",
+					char* storeDir = NULL,		// store of the counts, under the key of the
+					uint64_t storeKey = 0,		// sequence set, see SequenceSet::getHash()
+					bool revComp = false );		// also count the reverse complements of the sequences
 
 	BackgroundModel( std::string filePath );
     BackgroundModel(char* filePath , int K, float A );
@@ -44,9 +50,10 @@ public:
 	double 	calculateLogLikelihood( std::vector<Sequence*> sequenceSet );
 
 	// calculate positional likelihoods for the sequence set
-	// and write likelihoods to file
+	// and write likelihoods to file, as text (.lhs) or in the binary
+	// formats (.lhb) "float32", "float16" or "dict" (dictionary indices)
 	void 	calculatePosLikelihoods( std::vector<Sequence*> sequenceSet,
-			                      	  char* odir  );
+			                      	  char* odir, std::string format = "text" );
 
 
 	void 	print();
@@ -59,6 +66,15 @@ private:
 	void	calculateProbabilities( float** p );
 	// calculate conditional probabilities from counts
 	void 	calculateV();
+	// write positional likelihoods in a binary format
+	void	writePosLikelihoods( std::vector<Sequence*> seqs, char* odir, std::string format );
+	// count the (K+1)-mers of the sequences in parallel
+	void	countKmers( std::vector<Sequence*> seqs );
+
+	// (K+1)-mer count store, keyed by the content of the sequence set:
+	// counts of a higher order serve all lower orders and any alphas
+	bool		readCounts( std::string filePath, uint64_t hash );
+	void		writeCounts( char* storeDir, std::string filePath, uint64_t hash );
 
 	std::string			basename_;			// basename of sequence set file
 
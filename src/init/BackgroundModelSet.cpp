@@ -19,7 +19,7 @@ BackgroundModelSet::BackgroundModelSet( char* indir, char* extension,
 			if( stat( filep.c_str(), &sb ) == 0 && S_ISREG( sb.st_mode ) ){
 
 				char* ext = strrchr( ent->d_name, '.' );
-				if( strcmp( ext+1, extension ) == 0 ){
+				if( ext != NULL && strcmp( ext+1, extension ) == 0 ){
 
 					SequenceSet* sequenceSet = new SequenceSet( filep );
 
@@ -39,6 +39,8 @@ BackgroundModelSet::BackgroundModelSet( char* indir, char* extension,
 		perror( indir );
         exit( 1 );
 	}
+
+	stackModels();
 }
 
 BackgroundModelSet::BackgroundModelSet( char* indir, char* extension ){
@@ -58,7 +60,7 @@ BackgroundModelSet::BackgroundModelSet( char* indir, char* extension ){
 			if( stat( filep.c_str(), &sb ) == 0 && S_ISREG( sb.st_mode ) ){
 
 				char* ext = strrchr( ent->d_name, '.' );
-				if( strcmp( ext+1, extension ) == 0 ){
+				if( ext != NULL && strcmp( ext+1, extension ) == 0 ){
 
 					BackgroundModel* bamm = new BackgroundModel( filep );
 					backgroundModels_.push_back( bamm );
@@ -71,6 +73,8 @@ BackgroundModelSet::BackgroundModelSet( char* indir, char* extension ){
 		perror( indir );
         exit( 1 );
 	}
+
+	stackModels();
 }
 
 BackgroundModelSet::~BackgroundModelSet(){
@@ -78,6 +82,9 @@ BackgroundModelSet::~BackgroundModelSet(){
 	for( size_t i = 0; i < backgroundModels_.size(); i++ ){
 		delete backgroundModels_[i];
 	}
+	for( size_t k = 0; k < stackedV_.size(); k++ ){
+		free( stackedV_[k] );
+	}
 }
 
 std::vector<BackgroundModel*>& BackgroundModelSet::getBackgroundModels(){
@@ -91,15 +98,91 @@ size_t BackgroundModelSet::getN(){
 std::vector<double> BackgroundModelSet::calculateLogLikelihoods(
 		std::vector<Sequence*> seqs ){
 
-	std::vector<double> llikelihoods( backgroundModels_.size() );
+	size_t M = backgroundModels_.size();
+	if( stackedM_ != M ){
+		std::cerr << "Error: The stacked background models are out of date." << std::endl;
+		exit( 1 );
+	}
 
-	for( size_t i = 0; i < backgroundModels_.size(); i++ ){
+	size_t threads = 1;
+#ifdef OPENMP
+	threads = omp_in_parallel() ? 1 : omp_get_max_threads();
+#endif
+	// per-thread log likelihoods, summed up in thread order
+	std::vector<std::vector<double>> partial( threads, std::vector<double>( M, 0.0 ) );
+
+#pragma omp parallel for schedule( static ) num_threads( threads )
+	for( size_t s_idx = 0; s_idx < seqs.size(); s_idx++ ){
+
+		size_t t = 0;
+#ifdef OPENMP
+		t = omp_get_thread_num();
+#endif
+		double* ll = partial[t].data();
+
+		// get sequence length
+		size_t L = seqs[s_idx]->getL();
+		size_t* kmer = seqs[s_idx]->getKmer();
+
+		// loop over sequence positions, all models in a single pass
+		for( size_t i = 0; i < L; i++ ){
+			// calculate k
+			size_t k = std::min( i, stackedK_ );
+			// extract (k+1)mer and add the log probabilities of all models
+			const float* v = stackedV_[k] + ( kmer[i] % Y_[k+1] ) * M;
+#pragma omp simd
+			for( size_t m = 0; m < M; m++ ){
+				ll[m] += v[m];
+			}
+		}
+	}
 
-		llikelihoods[i] = backgroundModels_[i]->calculateLogLikelihood( seqs );
+	std::vector<double> llikelihoods( M, 0.0 );
+	for( size_t t = 0; t < threads; t++ ){
+		for( size_t m = 0; m < M; m++ ){
+			llikelihoods[m] += partial[t][m];
+		}
 	}
 	return llikelihoods;
 }
 
+void BackgroundModelSet::stackModels(){
+
+	for( size_t k = 0; k < stackedV_.size(); k++ ){
+		free( stackedV_[k] );
+	}
+
+	size_t M = backgroundModels_.size();
+	stackedM_ = M;
+	stackedK_ = 0;
+	for( size_t m = 0; m < M; m++ ){
+		stackedK_ = std::max( stackedK_, backgroundModels_[m]->getOrder() );
+	}
+
+	Y_.clear();
+	for( size_t k = 0; k < stackedK_+2; k++ ){
+		Y_.push_back( ipow( Alphabet::getSize(), k ) );
+	}
+
+	stackedV_.resize( stackedK_+1 );
+	for( size_t k = 0; k <= stackedK_; k++ ){
+		stackedV_[k] = ( float* )calloc( Y_[k+1] * M, sizeof( float ) );
+	}
+
+	for( size_t m = 0; m < M; m++ ){
+		float** v = backgroundModels_[m]->getV();
+		size_t K = backgroundModels_[m]->getOrder();
+		bool isLog = backgroundModels_[m]->vIsLog();
+		for( size_t k = 0; k <= stackedK_; k++ ){
+			size_t km = std::min( k, K );
+			for( size_t y = 0; y < Y_[k+1]; y++ ){
+				float value = v[km][y % Y_[km+1]];
+				stackedV_[k][y * M + m] = isLog ? value : logf( value );
+			}
+		}
+	}
+}
+
 std::vector<double> BackgroundModelSet::calculatePosteriorProbabilities(
 		std::vector<Sequence*> seqs ){
 
@@ -107,10 +190,12 @@ std::vector<double> BackgroundModelSet::calculatePosteriorProbabilities(
 }
 
 void BackgroundModelSet::calculatePosLikelihoods( std::vector<Sequence*> seqs,
-		char* odir ){
+		char* odir, std::string format ){
 
+	// each model writes its own file
+#pragma omp parallel for schedule( dynamic )
 	for( size_t i = 0; i < backgroundModels_.size(); i++ ){
-		backgroundModels_[i]->calculatePosLikelihoods( seqs, odir );
+		backgroundModels_[i]->calculatePosLikelihoods( seqs, odir, format );
 	}
 }
 
@@ -27,17 +27,21 @@ public:
 	std::vector<BackgroundModel*>& getBackgroundModels();
 	size_t getN();
 
-	// calculate log likelihoods for the sequence set
-	// afterwards the background init contain log probabilities in v_
+	// calculate log likelihoods for the sequence set from the stacked table,
+	// the background models are not modified and calls can run concurrently
 	std::vector<double> calculateLogLikelihoods( std::vector<Sequence*> seqs );
 
+	// (re)build the stacked table, needed after changing the background models
+	void stackModels();
+
 	// calculate posterior probabilities for the sequence set
 	std::vector<double> calculatePosteriorProbabilities( std::vector<Sequence*>
 															seqs );
 
 	// calculate positional likelihoods for the sequence set
-	// and write likelihoods to file
-	void calculatePosLikelihoods( std::vector<Sequence*> seqs, char* odir );
+	// and write likelihoods to file, see BackgroundModel for the formats
+	void calculatePosLikelihoods( std::vector<Sequence*> seqs, char* odir,
+								  std::string format = "text" );
 
 	void print();
 	void write( char* odir );
@@ -45,6 +49,13 @@ public:
 private:
 
 	std::vector<BackgroundModel*>	backgroundModels_;
+
+	// log probabilities of all M models stacked per (k+1)-mer: stackedV_[k][y*M+m],
+	// models of lower order than k are filled with their highest-order entries
+	std::vector<float*>				stackedV_;
+	size_t							stackedM_ = 0;	// number of models in stackedV_
+	size_t							stackedK_ = 0;	// highest model order
+	std::vector<size_t>				Y_;
 };
 
 #endif /* BACKGROUNDMODELSET_H_ */
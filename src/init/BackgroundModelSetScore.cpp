@@ -15,52 +15,90 @@ BackgroundModelSetScore::~BackgroundModelSetScore(){
 	}
 }
 
-void BackgroundModelSetScore::predict( char* indir, char* extensionSeqs ){
+void BackgroundModelSetScore::predict( char* indir, char* extensionSeqs, char* odir ){
 
-	DIR* dir;
-	struct dirent* ent;
+	std::vector<std::string> files = listFiles( indir, extensionSeqs );
 
-	struct stat sb;
+	posteriors_.clear();
+	posteriors_.resize( bamms_->getN() );
 
-	if( ( dir = opendir( indir ) ) != NULL ){
+	std::ofstream file;
+	if( odir != NULL ){
+		file.open( std::string( odir ) + '/' + "posterior.rows" );
+		if( !file.is_open() ){
+			std::cerr << "Error: Cannot write into output directory: " << odir << std::endl;
+			exit( 1 );
+		}
+		for( size_t i = 0; i < bammNames_.size(); i++ ){
+			file << '\t' << bammNames_[i];
+		}
+		file << std::endl;
+	}
 
-		posteriors_.clear();
-		posteriors_.resize( bamms_->getN() );
+	size_t threads = 1;
+#ifdef OPENMP
+	threads = omp_get_max_threads();
+#endif
 
-		while( ( ent = readdir( dir ) ) != NULL ){
+	// one sequence set per thread is held in memory at a time; a single set
+	// is scored on its own, such that its sequences are spread over the threads
+	for( size_t b = 0; b < files.size(); b += threads ){
 
-			std::string filep = std::string( indir ) + '/' +
-								std::string( ent->d_name );
+		size_t n = std::min( threads, files.size() - b );
+		std::vector<std::string> names( n );
+		std::vector<std::vector<double>> posteriors( n );
 
-			if( stat( filep.c_str(), &sb ) == 0 && S_ISREG( sb.st_mode ) ){
+#pragma omp parallel for schedule( dynamic ) if( n > 1 )
+		for( size_t j = 0; j < n; j++ ){
 
-				char* extension = strrchr( ent->d_name, '.' );
-				if( strcmp( extension+1, extensionSeqs ) == 0 ){
+			// each set draws its unknown letters from its own generator,
+			// such that the sets loaded concurrently do not share rand()
+			Xoshiro256 rng( 42, b+j );
+			SequenceSet* sequenceSet = new SequenceSet( files[b+j], false, "", &rng );
+			names[j] = baseName( sequenceSet->getSequenceFilepath().c_str() );
 
-					SequenceSet* sequenceSet = new SequenceSet( filep );
-					sequenceSetNames_.push_back( baseName(
-							sequenceSet->getSequenceFilepath().c_str() ) );
+			// calculate posterior probabilities
+			posteriors[j] = bamms_->calculatePosteriorProbabilities( sequenceSet->getSequences() );
+			delete sequenceSet;
+		}
 
-					// calculate posterior probabilities
-					std::vector<double> posteriors = bamms_->calculatePosteriorProbabilities( sequenceSet->getSequences() );
-					for( size_t i = 0; i < posteriors_.size(); i++ ){
-						posteriors_[i].push_back( posteriors[i] );
-					}
+		for( size_t j = 0; j < n; j++ ){
+			sequenceSetNames_.push_back( names[j] );
+			for( size_t i = 0; i < posteriors_.size(); i++ ){
+				posteriors_[i].push_back( posteriors[j][i] );
+			}
+			if( file.is_open() ){
+				file << names[j];
+				for( size_t i = 0; i < posteriors[j].size(); i++ ){
+					file << '\t' << std::fixed << std::setprecision( 6 ) << posteriors[j][i];
 				}
+				file << std::endl;
 			}
 		}
-		closedir( dir );
+	}
 
-		// calculate aggregate statistics
-		aggregate();
+	// calculate aggregate statistics
+	aggregate();
+}
 
-	} else{
-		perror( indir );
-        exit( 1 );
+void BackgroundModelSetScore::score( char* indir, char* extensionSeqs, char* odir, std::string format ){
+
+	std::vector<std::string> files = listFiles( indir, extensionSeqs );
+
+	for( size_t j = 0; j < files.size(); j++ ){
+
+		SequenceSet* sequenceSet = new SequenceSet( files[j] );
+		sequenceSetNames_.push_back( baseName( sequenceSet->getSequenceFilepath().c_str() ) );
+
+		// calculate positional likelihoods, the models in parallel
+		bamms_->calculatePosLikelihoods( sequenceSet->getSequences(), odir, format );
+		delete sequenceSet;
 	}
 }
 
-void BackgroundModelSetScore::score( char* indir, char* extensionSeqs, char* odir ){
+std::vector<std::string> BackgroundModelSetScore::listFiles( char* indir, char* extension ){
+
+	std::vector<std::string> files;
 
 	DIR* dir;
 	struct dirent* ent;
@@ -75,14 +113,9 @@ void BackgroundModelSetScore::score( char* indir, char* extensionSeqs, char* odi
 
 			if( stat( filep.c_str(), &sb ) == 0 && S_ISREG( sb.st_mode ) ){
 
-				char* extension = strrchr( ent->d_name, '.' );
-				if( strcmp( extension+1, extensionSeqs ) == 0 ){
-
-					SequenceSet* sequenceSet = new SequenceSet( filep );
-					sequenceSetNames_.push_back( baseName( sequenceSet->getSequenceFilepath().c_str() ) );
-
-					// calculate positional likelihoods
-					bamms_->calculatePosLikelihoods( sequenceSet->getSequences(), odir );
+				char* ext = strrchr( ent->d_name, '.' );
+				if( ext != NULL && strcmp( ext+1, extension ) == 0 ){
+					files.push_back( filep );
 				}
 			}
 		}
@@ -92,6 +125,8 @@ void BackgroundModelSetScore::score( char* indir, char* extensionSeqs, char* odi
 		perror( indir );
         exit( 1 );
 	}
+
+	return files;
 }
 
 void BackgroundModelSetScore::print(){
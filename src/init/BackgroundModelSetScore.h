@@ -16,10 +16,14 @@ public:
 	BackgroundModelSetScore( char* inputDirectoryBaMMs, char* extensionBaMMs );
 	~BackgroundModelSetScore();
 
-	// calculate posterior probabilities
-	void predict( char* inputDirectorySeqs, char* extensionSeqs );
-	// calculate positional likelihoods and write likelihoods to file
-	void score( char* inputDirectorySeqs, char* extensionSeqs, char* outputDirectory );
+	// calculate posterior probabilities, the sequence sets are loaded and scored
+	// in parallel, one batch of sets at a time; if an output directory is given,
+	// the posteriors of each set are appended to posterior.rows as they are ready
+	void predict( char* inputDirectorySeqs, char* extensionSeqs, char* outputDirectory = NULL );
+	// calculate positional likelihoods and write likelihoods to file,
+	// as text or in a binary format, see BackgroundModel
+	void score( char* inputDirectorySeqs, char* extensionSeqs, char* outputDirectory,
+				std::string format = "text" );
 
 	void print();
 	void write( char* outputDirectory );
@@ -29,6 +33,9 @@ private:
 	void aggregate();								// aggregate M x N matrix of
 													// posterior probabilities
 
+	// paths of the files in indir with the given extension, in directory order
+	std::vector<std::string> listFiles( char* indir, char* extension );
+
 	BackgroundModelSet* 		bamms_;
 	std::vector<std::string> 	bammNames_;			// names of M bg init
 	std::vector<std::string> 	sequenceSetNames_;	// basenames of N sequence
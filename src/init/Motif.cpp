@@ -188,6 +188,43 @@ void Motif::initFromBindingSites( char* indir, size_t l_flank, size_t r_flank ){
 
 }
 
+// posterior of the motif positions 1, ..., LW1 on a sequence and of no motif at 0,
+// given the PWM scores, for compile-time alphabet size A or asize at runtime for A = 0
+template<size_t A>
+static void pwmPosteriors( const size_t* kmer, size_t LW1, size_t W, size_t asize,
+						   std::vector<std::vector<float>>& score, float q, std::vector<float>& posterior ){
+
+	const size_t Y1 = ( A > 0 ) ? A : asize;
+
+	// calculate responsibilities over all LW1 positions on n'th sequence
+	std::vector<float> r;
+	r.resize( LW1 + 1 );
+
+	float normFactor = 0.0f;
+	// calculate positional prior:
+	float pos0 = 1.0f - q;
+	float pos1 = q / static_cast<float>( LW1 );
+
+	for( size_t i = 1; i <= LW1; i++ ){
+		r[i] = 1.0f;
+		for( size_t j = 0; j < W; j++ ){
+			// extract monomers from motif at position i
+			// over W of the n'th sequence
+			size_t y = kmer[i-1+j] % Y1;
+			r[i] *= score[y][j];
+		}
+		r[i] *= pos1;
+		normFactor += r[i];
+	}
+	// for sequences that do not contain motif
+	r[0] = pos0;
+	normFactor += r[0];
+	for( size_t i = 0; i <= LW1; i++ ){
+		r[i] /= normFactor;
+		posterior.push_back( r[i] );
+	}
+}
+
 // initialize v from PWM file
 void Motif::initFromPWM( float** PWM, size_t asize, SequenceSet* posSeqset, float q ){
 
@@ -250,60 +287,38 @@ void Motif::initFromPWM( float** PWM, size_t asize, SequenceSet* posSeqset, floa
                               << " short sequences have been neglected for sampling PWM."
                               << std::endl;
 
-#pragma omp parallel for
-
-	for( size_t n = 0; n < posSet.size(); n++ ){
-
-		size_t LW1 = posSet[n]->getL() - W_ + 1;
+	// the posteriors are calculated in parallel, the positions are drawn in
+	// sequence order afterwards such that the sampled model does not depend
+	// on the number of threads
+	std::vector<std::vector<float>> posteriors( posSet.size() );
 
-		// motif position
-		size_t z;
+	// the kernel specialized on the alphabet size, see kmerKernel() in utils.h
+	typedef void ( *PWMPosteriors )( const size_t*, size_t, size_t, size_t,
+									 std::vector<std::vector<float>>&, float, std::vector<float>& );
+	static const PWMPosteriors kernels[] = { pwmPosteriors<0>, pwmPosteriors<4> };
+	PWMPosteriors calcPosteriors = kernels[kmerKernel( 0, asize )];
 
-		// get the kmer array
-		size_t* kmer = posSet[n]->getKmer();
+#pragma omp parallel for
 
-		// calculate responsibilities over all LW1 positions on n'th sequence
-		std::vector<float> r;
-		r.resize( LW1 + 1 );
+	for( size_t n = 0; n < posSet.size(); n++ ){
+		calcPosteriors( posSet[n]->getKmer(), posSet[n]->getL() - W_ + 1, W_, asize, score, q, posteriors[n] );
+	}
 
-		std::vector<float> posteriors;
-		float normFactor = 0.0f;
-		// calculate positional prior:
-		float pos0 = 1.0f - q;
-		float pos1 = q / static_cast<float>( LW1 );
+	for( size_t n = 0; n < posSet.size(); n++ ){
 
-		// todo: could be parallelized by extracting 8 sequences at once
-		// todo: should be written in a faster way
-		for( size_t i = 1; i <= LW1; i++ ){
-			r[i] = 1.0f;
-			for( size_t j = 0; j < W_; j++ ){
-				// extract monomers from motif at position i
-				// over W of the n'th sequence
-				size_t y = kmer[i-1+j] % asize;
-				r[i] *= score[y][j];
-			}
-			r[i] *= pos1;
-			normFactor += r[i];
-		}
-		// for sequences that do not contain motif
-		r[0] = pos0;
-		normFactor += r[0];
-		for( size_t i = 0; i <= LW1; i++ ){
-			r[i] /= normFactor;
-			posteriors.push_back( r[i] );
-		}
 		// draw a new position z from discrete posterior distribution
-		std::discrete_distribution<size_t> posterior_dist( posteriors.begin(), posteriors.end() );
+		std::discrete_distribution<size_t> posterior_dist( posteriors[n].begin(), posteriors[n].end() );
 
 		// draw a sample z randomly
-		z = posterior_dist( rngx );
+		size_t z = posterior_dist( rngx );
 
 		// count kmers with sampled z
 		if( z > 0 ){
+			size_t* kmer = posSet[n]->getKmer();
 			for( size_t k = 0; k < K_+1; k++ ){
 				for( size_t j = 0; j < W_; j++ ){
 					size_t y = kmer[z-1+j] % Y_[k+1];
-                    __sync_fetch_and_add(&(n_[k][y][j]), 1);
+					n_[k][y][j]++;
 				}
 			}
 		}
@@ -396,6 +411,59 @@ void Motif::initFromBaMM( char* indir, size_t l_flank, size_t r_flank ){
     }
 }
 
+void Motif::initFromBinary( const char* record, size_t l_flank, size_t r_flank ){
+
+	uint32_t header[5];	// W, K, k_bg, q, length of the name
+	memcpy( header, record, sizeof( header ) );
+	if( header[0] + l_flank + r_flank != W_ or header[1] != K_ ){
+		std::cerr << "Error: The binary BaMM record does not match the motif." << std::endl;
+		exit( 1 );
+	}
+	size_t W = header[0];
+
+	// skip the name, padded to 4 bytes
+	const char* data = record + sizeof( header ) + ( ( header[4] + 3 ) / 4 ) * 4;
+
+	// alphas, v and p of the core region
+	for( size_t k = 0; k < K_+1; k++ ){
+		memcpy( A_[k] + l_flank, data, W * sizeof( float ) );
+		data += W * sizeof( float );
+	}
+	for( size_t k = 0; k < K_+1; k++ ){
+		for( size_t y = 0; y < Y_[k+1]; y++ ){
+			memcpy( v_[k][y] + l_flank, data, W * sizeof( float ) );
+			data += W * sizeof( float );
+		}
+	}
+
+	// set each v to 0.25f in the flanking region
+	for( size_t k = 0; k < K_+1; k++ ){
+		for( size_t y = 0; y < Y_[k+1]; y++ ){
+			for( size_t j = 0; j < l_flank; j++ ){
+				v_[k][y][j] = 1.0f / static_cast<float>( Y_[1] );
+			}
+			for( size_t j = W_ - r_flank; j < W_; j++ ){
+				v_[k][y][j] = 1.0f / static_cast<float>( Y_[1] );
+			}
+		}
+	}
+
+	// the stored p are final for the background order the motif was learned
+	// with; they are only recalculated for added flanks or another order
+	if( l_flank == 0 and r_flank == 0 and header[2] == k_bg_ ){
+		for( size_t k = 0; k < K_+1; k++ ){
+			for( size_t y = 0; y < Y_[k+1]; y++ ){
+				memcpy( p_[k][y], data, W * sizeof( float ) );
+				data += W * sizeof( float );
+			}
+		}
+	} else {
+		calculateP();
+	}
+
+	isInitialized_ = true;
+}
+
 float** Motif::getS(){
 	return s_;
 }
@@ -545,3 +613,106 @@ void Motif::write( char* odir, std::string basename ){
 		ofile_p << std::endl;
 	}
 }
+
+/**
+ * binary BaMM file (.ihbb), little-endian, holding one or more models:
+ * "BaMMbin" and a format version byte
+ * uint32_t	alphabet size
+ * uint32_t	number of models N
+ * uint64_t	N byte offsets of the model records from the start of the file
+ * each record, starting at a multiple of 8 bytes:
+ * uint32_t	W, K, background model order, float q, uint32_t length of the name
+ * char		name, padded with zeros to a multiple of 4 bytes
+ * float	alphas A[k][j], conditional probabilities v[k][y][j] and
+ * 			probabilities p[k][y][j], with j running fastest
+ */
+static const char	binaryMagic[8] = { 'B', 'a', 'M', 'M', 'b', 'i', 'n', 1 };
+
+void Motif::writeBinary( char* odir, std::string basename ){
+
+	writeBinary( std::vector<Motif*>( 1, this ), std::vector<std::string>( 1, basename ),
+				 std::string( odir ) + '/' + basename + ".ihbb" );
+}
+
+void Motif::writeBinary( std::vector<Motif*> motifs, std::vector<std::string> names,
+						 std::string filePath ){
+
+	FILE* file = fopen( filePath.c_str(), "wb" );
+	if( file == NULL ){
+		std::cerr << "Error: Cannot write binary BaMM file: " << filePath << std::endl;
+		exit( 1 );
+	}
+
+	uint32_t header[2] = { static_cast<uint32_t>( Alphabet::getSize() ),
+						   static_cast<uint32_t>( motifs.size() ) };
+
+	// record sizes, padded to 8 bytes
+	std::vector<uint64_t> offsets( motifs.size() );
+	uint64_t offset = sizeof( binaryMagic ) + sizeof( header ) + motifs.size() * sizeof( uint64_t );
+	offset = ( offset + 7 ) / 8 * 8;
+	for( size_t i = 0; i < motifs.size(); i++ ){
+		Motif* m = motifs[i];
+		size_t floats = ( m->K_+1 ) * m->W_;
+		for( size_t k = 0; k < m->K_+1; k++ ){
+			floats += 2 * m->Y_[k+1] * m->W_;
+		}
+		offsets[i] = offset;
+		offset += 5 * sizeof( uint32_t ) + ( names[i].size() + 3 ) / 4 * 4 + floats * sizeof( float );
+		offset = ( offset + 7 ) / 8 * 8;
+	}
+
+	bool ok = fwrite( binaryMagic, 1, sizeof( binaryMagic ), file ) == sizeof( binaryMagic )
+			and fwrite( header, sizeof( uint32_t ), 2, file ) == 2
+			and fwrite( offsets.data(), sizeof( uint64_t ), offsets.size(), file ) == offsets.size();
+
+	const char zeros[8] = { 0 };
+	for( size_t i = 0; ok and i < motifs.size(); i++ ){
+		Motif* m = motifs[i];
+		// pad to the start of the record
+		long pos = ftell( file );
+		ok = ok and pos >= 0 and static_cast<uint64_t>( pos ) <= offsets[i]
+				and fwrite( zeros, 1, offsets[i] - pos, file ) == offsets[i] - pos;
+
+		uint32_t fields[5] = { static_cast<uint32_t>( m->W_ ), static_cast<uint32_t>( m->K_ ),
+							   static_cast<uint32_t>( m->k_bg_ ), 0,
+							   static_cast<uint32_t>( names[i].size() ) };
+		float q = m->q_;
+		memcpy( &fields[3], &q, sizeof( float ) );
+		size_t pad = ( names[i].size() + 3 ) / 4 * 4 - names[i].size();
+		ok = ok and fwrite( fields, sizeof( uint32_t ), 5, file ) == 5
+				and fwrite( names[i].data(), 1, names[i].size(), file ) == names[i].size()
+				and fwrite( zeros, 1, pad, file ) == pad;
+
+		for( size_t k = 0; k < m->K_+1; k++ ){
+			ok = ok and fwrite( m->A_[k], sizeof( float ), m->W_, file ) == m->W_;
+		}
+		for( size_t k = 0; k < m->K_+1; k++ ){
+			for( size_t y = 0; y < m->Y_[k+1]; y++ ){
+				ok = ok and fwrite( m->v_[k][y], sizeof( float ), m->W_, file ) == m->W_;
+			}
+		}
+		for( size_t k = 0; k < m->K_+1; k++ ){
+			for( size_t y = 0; y < m->Y_[k+1]; y++ ){
+				ok = ok and fwrite( m->p_[k][y], sizeof( float ), m->W_, file ) == m->W_;
+			}
+		}
+	}
+
+	if( fclose( file ) != 0 or !ok ){
+		std::cerr << "Error: Cannot write binary BaMM file: " << filePath << std::endl;
+		exit( 1 );
+	}
+}
+
+bool Motif::isBinary( const char* filePath ){
+
+	char magic[8];
+	FILE* file = fopen( filePath, "rb" );
+	if( file == NULL ){
+		return false;
+	}
+	bool binary = fread( magic, 1, sizeof( magic ), file ) == sizeof( magic )
+				  and memcmp( magic, binaryMagic, 7 ) == 0;
+	fclose( file );
+	return binary;
+}
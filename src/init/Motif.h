@@ -27,11 +27,15 @@ public:
 
 	void initFromBaMM( char* indir, size_t l_flank, size_t r_flank );
 
+	// initialize from a model record of a binary BaMM file (.ihbb), see writeBinary()
+	void initFromBinary( const char* record, size_t l_flank, size_t r_flank );
+
 	size_t				getW(); 					// get motif length w
 	size_t				getK();						// get motif model order k
     float               getQ();                     // get estimated motif fraction on the sequences q
 	float**				getA();						// get motif hyperparameter alpha
 	float***    		getV();						// get conditional probabilities v
+	float***    		getP();						// get probabilities p
 	float**				getS();						// get log odds scores for the highest order K at position j
 	std::vector<size_t> getY();
 
@@ -43,6 +47,13 @@ public:
 
 	void 				print();					// print v to console
 	void 				write( char* odir, std::string basename );
+	void				writeBinary( char* odir, std::string basename );	// write to a binary BaMM file
+
+	// write the motifs into a single binary BaMM file, e.g. a model library
+	static void			writeBinary( std::vector<Motif*> motifs, std::vector<std::string> names,
+									 std::string filePath );
+	// check for the header of a binary BaMM file
+	static bool			isBinary( const char* filePath );
 
 private:
 
@@ -87,6 +98,10 @@ inline float*** Motif::getV(){
 	return v_;
 }
 
+inline float*** Motif::getP(){
+	return p_;
+}
+
 inline std::vector<size_t> Motif::getY(){
 	return Y_;
 }
@@ -156,6 +156,11 @@ MotifSet::MotifSet( char* indir,
             exit( 1 );
         }
 
+	} else if( tag.compare( "BaMM" ) == 0 and Motif::isBinary( indir ) ){
+
+		// a binary BaMM file contains one or more models
+		readBinary( indir, l_flank, r_flank, v_bg, k_bg );
+
 	} else if( tag.compare( "BaMM" ) == 0 ){
 
 		// each BaMM file contains one optimized motif model
@@ -222,6 +227,103 @@ MotifSet::MotifSet( char* indir,
 	}
 }
 
+void MotifSet::readBinary( char* indir, size_t l_flank, size_t r_flank,
+						   float** v_bg, size_t k_bg ){
+
+	int fd = open( indir, O_RDONLY );
+	struct stat sb;
+	if( fd < 0 or fstat( fd, &sb ) != 0 ){
+		std::cerr << "Error: Cannot open BaMM file: " << indir << std::endl;
+		exit( 1 );
+	}
+	size_t size = static_cast<size_t>( sb.st_size );
+	void* mapped = ( size > 0 ) ? mmap( NULL, size, PROT_READ, MAP_PRIVATE, fd, 0 ) : MAP_FAILED;
+	close( fd );
+	if( mapped == MAP_FAILED ){
+		std::cerr << "Error: Cannot read BaMM file: " << indir << std::endl;
+		exit( 1 );
+	}
+	const char* data = static_cast<const char*>( mapped );
+
+	// header: magic and version, alphabet size, number of models and their offsets
+	uint32_t header[2];
+	if( size < 16 or data[7] != 1 ){
+		std::cerr << "Error: Unsupported version of the binary BaMM file: " << indir << std::endl;
+		exit( 1 );
+	}
+	memcpy( header, data + 8, sizeof( header ) );
+	if( header[0] != Alphabet::getSize() ){
+		std::cerr << "Error: The alphabet size of the BaMM file does not match: " << indir << std::endl;
+		exit( 1 );
+	}
+	size_t N = header[1];
+	if( 16 + N * sizeof( uint64_t ) > size ){
+		std::cerr << "This is not a BaMM-format file: " << indir << std::endl;
+		exit( 1 );
+	}
+
+	maxW_ = 0;
+	for( size_t i = 0; i < N; i++ ){
+
+		uint64_t offset;
+		memcpy( &offset, data + 16 + i * sizeof( uint64_t ), sizeof( uint64_t ) );
+
+		// W, K, background model order, q and length of the name
+		uint32_t fields[5];
+		if( offset + sizeof( fields ) > size ){
+			std::cerr << "This is not a BaMM-format file: " << indir << std::endl;
+			exit( 1 );
+		}
+		memcpy( fields, data + offset, sizeof( fields ) );
+		size_t W = fields[0];
+		size_t K = fields[1];
+		float q;
+		memcpy( &q, &fields[3], sizeof( float ) );
+		if( K > 8 ){
+			std::cerr << "The input BaMM model order is too high: " << indir << std::endl;
+			exit( 1 );
+		}
+		// p is then recalculated, but the model was learned relative to the stored background order
+		if( v_bg != NULL and fields[2] != k_bg ){
+			std::cerr << "Warning: Model " << i+1 << " of the BaMM file was learned with a background model of order "
+					  << fields[2] << ", the current one has order " << k_bg << ": " << indir << std::endl;
+		}
+
+		// check that the record lies within the file
+		size_t floats = ( K+1 ) * W;
+		for( size_t k = 0; k < K+1; k++ ){
+			floats += 2 * ipow( Alphabet::getSize(), k+1 ) * W;
+		}
+		size_t start = offset + sizeof( fields ) + ( fields[4] + 3 ) / 4 * 4;
+		if( W == 0 or start + floats * sizeof( float ) > size ){
+			std::cerr << "This is not a BaMM-format file: " << indir << std::endl;
+			exit( 1 );
+		}
+
+		// the alphas of the first position are used for the flanking region
+		std::vector<float> alphas( K+1 );
+		for( size_t k = 0; k < K+1; k++ ){
+			memcpy( &alphas[k], data + start + k * W * sizeof( float ), sizeof( float ) );
+		}
+
+		// the tables are copied out of the mapping into the motif, which owns them
+		Motif* motif = new Motif( W + l_flank + r_flank, K, alphas, v_bg, k_bg, q );
+		motif->initFromBinary( data + offset, l_flank, r_flank );
+
+		motifs_.push_back( motif );
+		N_++;
+
+		maxW_ = ( motif->getW() > maxW_ ) ? motif->getW() : maxW_;
+	}
+
+	munmap( mapped, size );
+
+	if( N_ == 0 ){
+		std::cerr << "Error: Cannot find any model in the BaMM file: " << indir << std::endl;
+		exit( 1 );
+	}
+}
+
 MotifSet::~MotifSet(){
     for( size_t i = 0; i < motifs_.size(); i++ ){
         delete motifs_[i];
@@ -1,6 +1,9 @@
 #ifndef MOTIFSET_H_
 #define MOTIFSET_H_
 
+#include <fcntl.h>		// e.g. open
+#include <sys/mman.h>	// e.g. mmap
+
 #include "Motif.h"
 #include "../refinement/utils.h"
 
@@ -26,6 +29,9 @@ private:
 	size_t         		N_;					// number of motifs
     size_t              maxW_;              // maximal length of motifs
 
+	// read all models of a binary BaMM file (.ihbb)
+	void				readBinary( char* indir, size_t l_flank, size_t r_flank,
+									float** v_bg, size_t k_bg );
 };
 
 #endif /* MOTIFSET_H_ */
@@ -0,0 +1,253 @@
+#include "RecordWriter.h"
+
+#include <math.h>		// e.g. floor
+#include <stdlib.h>		// e.g. exit
+
+RecordWriter::RecordWriter( std::string filePath, size_t bufferSize, bool background ){
+
+	filePath_ = filePath;
+	file_ = fopen( filePath.c_str(), "wb" );
+	if( file_ == NULL ){
+		std::cerr << "Error: Cannot open file: " << filePath << std::endl;
+		exit( 1 );
+	}
+	init( bufferSize, background );
+}
+
+RecordWriter::RecordWriter( FILE* file, size_t bufferSize, bool background ){
+
+	file_ = file;
+	init( bufferSize, background );
+}
+
+void RecordWriter::init( size_t bufferSize, bool background ){
+
+	buffer_.resize( bufferSize > 0 ? bufferSize : 1 );
+	size_ = 0;
+	background_ = background;
+	done_ = false;
+	failed_ = false;
+
+	if( background_ ){
+		thread_ = std::thread( &RecordWriter::run, this );
+	}
+}
+
+RecordWriter::~RecordWriter(){
+	close();
+}
+
+RecordWriter& RecordWriter::put( float value, int precision ){
+
+	/**
+	 * format the value as %.<precision>g, i.e. as an ostream with
+	 * std::setprecision( precision ) does: the value is scaled by an exact
+	 * power of ten to precision digits, values too close to a rounding tie,
+	 * out of the range of exact powers or not finite are left to snprintf
+	 */
+
+	static const double pow10[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+									1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+	char s[32];
+	size_t n = 0;
+
+	double a = fabs( static_cast<double>( value ) );
+	int P = ( precision < 1 ) ? 1 : precision;
+
+	if( a == 0.0 ){
+		if( signbit( value ) ){
+			s[n++] = '-';
+		}
+		s[n++] = '0';
+		return putBinary( s, n );
+	}
+
+	bool exact = ( P <= 9 and isfinite( a ) );
+	int e = 0;
+	uint64_t digits = 0;
+
+	if( exact ){
+		e = static_cast<int>( floor( log10( a ) ) );
+		for( int iter = 0; iter < 2; iter++ ){
+			int k = P - 1 - e;
+			if( k > 22 or k < -22 ){
+				exact = false;
+				break;
+			}
+			double m = ( k >= 0 ) ? a * pow10[k] : a / pow10[-k];
+			// correct an estimate of the exponent that is off by one
+			if( m < pow10[P-1] ){
+				e--;
+				continue;
+			} else if( m >= pow10[P] ){
+				e++;
+				continue;
+			}
+			double f = m - floor( m );
+			if( fabs( f - 0.5 ) < 1e-6 ){
+				exact = false;
+				break;
+			}
+			digits = static_cast<uint64_t>( floor( m + 0.5 ) );
+			if( digits == static_cast<uint64_t>( pow10[P] ) ){
+				digits /= 10;
+				e++;
+			}
+			break;
+		}
+		if( digits == 0 ){
+			exact = false;
+		}
+	}
+
+	if( !exact ){
+		int len = snprintf( s, sizeof( s ), "%.*g", P, static_cast<double>( value ) );
+		return putBinary( s, static_cast<size_t>( len ) );
+	}
+
+	// significant digits with trailing zeros removed
+	char d[10];
+	int nd = P;
+	for( int i = P-1; i >= 0; i-- ){
+		d[i] = char( '0' + digits % 10 );
+		digits /= 10;
+	}
+	while( nd > 1 and d[nd-1] == '0' ){
+		nd--;
+	}
+
+	if( value < 0 ){
+		s[n++] = '-';
+	}
+	if( e < -4 or e >= P ){
+		s[n++] = d[0];
+		if( nd > 1 ){
+			s[n++] = '.';
+			for( int i = 1; i < nd; i++ ){
+				s[n++] = d[i];
+			}
+		}
+		s[n++] = 'e';
+		s[n++] = ( e < 0 ) ? '-' : '+';
+		int x = ( e < 0 ) ? -e : e;
+		if( x >= 100 ){
+			s[n++] = char( '0' + x / 100 );
+		}
+		s[n++] = char( '0' + ( x / 10 ) % 10 );
+		s[n++] = char( '0' + x % 10 );
+	} else if( e < 0 ){
+		s[n++] = '0';
+		s[n++] = '.';
+		for( int i = 0; i < -e-1; i++ ){
+			s[n++] = '0';
+		}
+		for( int i = 0; i < nd; i++ ){
+			s[n++] = d[i];
+		}
+	} else {
+		for( int i = 0; i <= e; i++ ){
+			s[n++] = ( i < nd ) ? d[i] : '0';
+		}
+		if( nd > e+1 ){
+			s[n++] = '.';
+			for( int i = e+1; i < nd; i++ ){
+				s[n++] = d[i];
+			}
+		}
+	}
+	return putBinary( s, n );
+}
+
+bool RecordWriter::close(){
+
+	if( file_ == NULL ){
+		return !failed_;
+	}
+
+	flush();
+
+	if( background_ ){
+		{
+			std::unique_lock<std::mutex> lock( mutex_ );
+			done_ = true;
+		}
+		cond_.notify_all();
+		thread_.join();
+	}
+
+	if( fclose( file_ ) != 0 ){
+		failed_ = true;
+	}
+	file_ = NULL;
+
+	if( failed_ and !filePath_.empty() ){
+		std::cerr << "Error: Cannot write file: " << filePath_ << std::endl;
+		exit( 1 );
+	}
+	return !failed_;
+}
+
+void RecordWriter::flush(){
+
+	if( size_ == 0 ){
+		return;
+	}
+
+	if( !background_ ){
+		if( fwrite( buffer_.data(), 1, size_, file_ ) != size_ ){
+			failed_ = true;
+		}
+		size_ = 0;
+		return;
+	}
+
+	std::unique_lock<std::mutex> lock( mutex_ );
+	// keep at most two buffers in the queue, i.e. wait for a slow disk
+	cond_.wait( lock, [this]{ return queue_.size() < 2; } );
+
+	std::vector<char> buffer;
+	if( !free_.empty() ){
+		buffer.swap( free_.back() );
+		free_.pop_back();
+	}
+	if( buffer.size() < buffer_.size() ){
+		buffer.resize( buffer_.size() );
+	}
+	queue_.push_back( std::make_pair( std::vector<char>(), size_ ) );
+	queue_.back().first.swap( buffer_ );
+	buffer_.swap( buffer );
+	size_ = 0;
+
+	lock.unlock();
+	cond_.notify_all();
+}
+
+void RecordWriter::run(){
+
+	std::unique_lock<std::mutex> lock( mutex_ );
+
+	while( true ){
+
+		cond_.wait( lock, [this]{ return done_ or !queue_.empty(); } );
+		if( queue_.empty() ){
+			break;		// done_ and nothing left to write
+		}
+
+		std::pair<std::vector<char>, size_t> item;
+		item.swap( queue_.front() );
+
+		// write without the lock, while the next buffer is filled
+		lock.unlock();
+		bool ok = ( fwrite( item.first.data(), 1, item.second, file_ ) == item.second );
+		lock.lock();
+
+		if( !ok ){
+			failed_ = true;
+		}
+		queue_.pop_front();
+		free_.push_back( std::vector<char>() );
+		free_.back().swap( item.first );
+		cond_.notify_all();
+	}
+}
@@ -0,0 +1,117 @@
+#ifndef RECORDWRITER_H_
+#define RECORDWRITER_H_
+
+#include <condition_variable>
+#include <deque>
+#include <iostream>	// e.g. std::cerr
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <stdint.h>	// e.g. uint64_t
+#include <stdio.h>	// e.g. fopen
+#include <string.h>	// e.g. memcpy
+
+class RecordWriter{
+
+	/*
+	 * Buffered writer for files of many records, e.g. motif occurrences: the
+	 * fields are formatted into a large buffer without streams and without
+	 * flushing line by line, and full buffers are passed through a queue to
+	 * a background thread, which writes them while the next one is filled.
+	 */
+
+public:
+
+	RecordWriter( std::string filePath, size_t bufferSize = 1 << 22, bool background = true );
+	// take over an open file, e.g. of a socket: failures to write it are not fatal
+	// but returned by close(), e.g. when the other end has gone
+	RecordWriter( FILE* file, size_t bufferSize = 1 << 16, bool background = false );
+	~RecordWriter();									// writes the rest and closes the file
+
+	RecordWriter&	put( char c );
+	RecordWriter&	put( const char* s );
+	RecordWriter&	put( const std::string& s );
+	RecordWriter&	put( size_t value );				// decimal
+	RecordWriter&	put( float value, int precision );	// as an ostream with std::setprecision( precision )
+	RecordWriter&	putBinary( const void* data, size_t bytes );
+
+	bool			close();							// false if the file could not be written
+
+private:
+
+	void			init( size_t bufferSize, bool background );
+	void			reserve( size_t bytes );			// make room for bytes in buffer_
+	void			flush();							// pass buffer_ to the background thread
+	void			run();								// background thread: write the queued buffers
+
+	std::string					filePath_;
+	FILE*						file_;
+	std::vector<char>			buffer_;
+	size_t						size_;				// bytes used in buffer_
+	bool						background_;
+
+	std::thread					thread_;
+	std::mutex					mutex_;
+	std::condition_variable		cond_;
+	std::deque<std::pair<std::vector<char>, size_t>>	queue_;	// full buffers and their sizes
+	std::vector<std::vector<char>>	free_;			// written buffers for reuse
+	bool						done_;
+	bool						failed_;
+};
+
+inline RecordWriter& RecordWriter::put( char c ){
+	if( size_ == buffer_.size() ){
+		flush();
+	}
+	buffer_[size_++] = c;
+	return *this;
+}
+
+inline RecordWriter& RecordWriter::put( const char* s ){
+	size_t bytes = strlen( s );
+	reserve( bytes );
+	memcpy( buffer_.data() + size_, s, bytes );
+	size_ += bytes;
+	return *this;
+}
+
+inline RecordWriter& RecordWriter::put( const std::string& s ){
+	reserve( s.size() );
+	memcpy( buffer_.data() + size_, s.data(), s.size() );
+	size_ += s.size();
+	return *this;
+}
+
+inline RecordWriter& RecordWriter::put( size_t value ){
+	char digits[20];
+	size_t n = 0;
+	do{
+		digits[n++] = char( '0' + value % 10 );
+		value /= 10;
+	} while( value > 0 );
+	reserve( n );
+	while( n > 0 ){
+		buffer_[size_++] = digits[--n];
+	}
+	return *this;
+}
+
+inline RecordWriter& RecordWriter::putBinary( const void* data, size_t bytes ){
+	reserve( bytes );
+	memcpy( buffer_.data() + size_, data, bytes );
+	size_ += bytes;
+	return *this;
+}
+
+inline void RecordWriter::reserve( size_t bytes ){
+	if( size_ + bytes > buffer_.size() ){
+		flush();
+		if( bytes > buffer_.size() ){
+			buffer_.resize( bytes );
+		}
+	}
+}
+
+#endif /* RECORDWRITER_H_ */
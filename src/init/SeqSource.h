@@ -0,0 +1,32 @@
+#ifndef SEQSOURCE_H_
+#define SEQSOURCE_H_
+
+#include <stddef.h>	// e.g. size_t
+#include <stdint.h>	// e.g. uint8_t
+#include <string>
+
+class SeqSource{
+
+	/*
+	 * A sequence set whose sequences are generated on demand instead of
+	 * being kept in memory, e.g. background sequences drawn from a seed
+	 * and their index. Sequence n is the same on every call and the
+	 * sequences can be generated concurrently. The sequences are single-
+	 * stranded, with k-mer values as in Sequence::getKmer().
+	 */
+
+public:
+
+	virtual ~SeqSource(){}
+
+	virtual size_t	getN() = 0;					// number of sequences
+	virtual size_t	getL( size_t n ) = 0;		// length of sequence n
+	virtual size_t	getMaxL() = 0;				// maximal sequence length
+	virtual std::string	getHeader( size_t n ) = 0;
+
+					// write the letters and k-mer values of sequence n into
+					// buffers of (at least) getL( n ) entries
+	virtual void	generate( size_t n, uint8_t* sequence, size_t* kmer ) = 0;
+};
+
+#endif /* SEQSOURCE_H_ */
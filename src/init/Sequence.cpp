@@ -1,11 +1,17 @@
 #include "Sequence.h"
 #include "../refinement/utils.h"
 
+// a random letter for an unknown letter, drawn from rng or by rand()
+static size_t randomLetter( Xoshiro256* rng, size_t A ){
+	return ( rng != NULL ) ? ( size_t )( ( ( ( *rng )() >> 32 ) * A ) >> 32 ) : ( size_t )rand() % A;
+}
+
 Sequence::Sequence( uint8_t* sequence,
 					size_t L,
 					std::string header,
 					std::vector<size_t> Y,
-					bool singleStrand ){
+					bool singleStrand,
+					Xoshiro256* rng ){
 
 	if( !singleStrand ){
 		L_ = 2 * L + 1;
@@ -35,13 +41,29 @@ Sequence::Sequence( uint8_t* sequence,
 	kmer_ = ( size_t* )calloc( L_, sizeof( size_t ) );
 	for( size_t i = 0; i < L_; i++ ){
 		for( size_t k = i < 10 ? i+1 : 11; k > 0; k-- ){
-			kmer_[i] += ( ( sequence_[i-k+1] == 0 ) ? ( size_t )rand() % Y_[1] :
+			kmer_[i] += ( ( sequence_[i-k+1] == 0 ) ? randomLetter( rng, Y_[1] ) :
 						( sequence_[i-k+1] - 1 ) ) * Y_[k-1];
 		}
 	}
 
 }
 
+Sequence::Sequence( uint8_t* sequence,
+					size_t* kmer,
+					size_t L,
+					std::string header,
+					std::vector<size_t> Y ){
+
+	L_ = L;
+	sequence_ = sequence;
+	kmer_ = kmer;
+	header_ = header;
+
+	for( size_t i = 0; i < 12; i++ ){
+		Y_.push_back( ipow( Alphabet::getSize(), i ) );
+	}
+}
+
 Sequence::~Sequence(){
 	if( sequence_ != NULL ){
 		free( sequence_ );
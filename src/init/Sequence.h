@@ -9,6 +9,8 @@
 
 #include "Alphabet.h"
 
+class Xoshiro256;	// see utils.h
+
 class Sequence{
 
 public:
@@ -17,7 +19,16 @@ public:
 				size_t L,
 				std::string header,
 				std::vector<size_t> Y,
-				bool singleStrand = false );
+				bool singleStrand = false,
+				Xoshiro256* rng = NULL );	// draws the letters for unknown letters,
+											// which are otherwise drawn by rand()
+				// take over an encoded single-strand sequence and its k-mer array,
+				// both allocated with calloc
+	Sequence( uint8_t* sequence,
+				size_t* kmer,
+				size_t L,
+				std::string header,
+				std::vector<size_t> Y );
 	~Sequence();
 
 	uint8_t*		getSequence();
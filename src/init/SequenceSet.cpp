@@ -3,7 +3,8 @@
 
 SequenceSet::SequenceSet( std::string sequenceFilepath,
 							bool singleStrand,
-							std::string intensityFilepath ){
+							std::string intensityFilepath,
+							Xoshiro256* rng ){
 
 	if( Alphabet::getSize() == 0 ){
 		std::cerr << "Error: Initialize Alphabet before "
@@ -19,7 +20,7 @@ SequenceSet::SequenceSet( std::string sequenceFilepath,
 
 	baseFrequencies_ = new float[Y_[1]];
 
-	readFASTA( singleStrand );
+	readFASTA( singleStrand, rng );
 
 	if( !( intensityFilepath.empty() ) ){
 		intensityFilepath_ = intensityFilepath;
@@ -60,11 +61,55 @@ float* SequenceSet::getBaseFrequencies(){
 	return baseFrequencies_;
 }
 
+uint64_t SequenceSet::getHash(){
+	return hash_;
+}
+
+// FNV-1a over 8-byte words, with a shift to mix the high bits down
+static uint64_t hashBytes( uint64_t hash, const char* data, size_t bytes ){
+
+	size_t i = 0;
+	for( ; i + 8 <= bytes; i += 8 ){
+		uint64_t word;
+		memcpy( &word, data + i, 8 );
+		hash = ( hash ^ word ) * 1099511628211ULL;
+		hash ^= hash >> 32;
+	}
+	// the remaining bytes, with their number in the top byte to separate lines
+	uint64_t word = uint64_t( bytes - i ) << 56;
+	memcpy( &word, data + i, bytes - i );
+	hash = ( hash ^ word ) * 1099511628211ULL;
+	return hash ^ ( hash >> 32 );
+}
+
+// FNV-1a hash over the alphabet, the lengths and the letters of the sequences
+uint64_t SequenceSet::hashSequences( std::vector<Sequence*> seqs ){
+
+	uint64_t hash = 14695981039346656037ULL;
+	auto add = [&hash]( uint64_t value, size_t bytes ){
+		for( size_t b = 0; b < bytes; b++ ){
+			hash = ( hash ^ ( ( value >> ( 8 * b ) ) & 0xFF ) ) * 1099511628211ULL;
+		}
+	};
+
+	add( Alphabet::getSize(), 8 );
+	add( seqs.size(), 8 );
+	for( size_t s_idx = 0; s_idx < seqs.size(); s_idx++ ){
+		size_t L = seqs[s_idx]->getL();
+		uint8_t* sequence = seqs[s_idx]->getSequence();
+		add( L, 8 );
+		for( size_t i = 0; i < L; i++ ){
+			hash = ( hash ^ sequence[i] ) * 1099511628211ULL;
+		}
+	}
+	return hash;
+}
+
 void SequenceSet::print(){
 
 }
 
-int SequenceSet::readFASTA( bool singleStrand ){
+int SequenceSet::readFASTA( bool singleStrand, Xoshiro256* rng ){
 
 	/**
 	 * while reading in the sequences do:
@@ -80,10 +125,20 @@ int SequenceSet::readFASTA( bool singleStrand ){
 	std::string line, header, sequence;
 	std::ifstream file( sequenceFilepath_.c_str() ); // opens FASTA file
 
+	/**
+	 * hash the lines of the file while they are read, together with the
+	 * alphabet and the strand setting, which both change the sequences
+	 */
+	hash_ = 14695981039346656037ULL;
+	uint64_t setting[2] = { Alphabet::getSize(), singleStrand };
+	hash_ = hashBytes( hash_, ( const char* )setting, sizeof( setting ) );
+
 	if( file.is_open() ){
 
 		while( getline( file, line ) ){
 
+			hash_ = hashBytes( hash_, line.data(), line.size() );
+
 			if( !( line.empty() ) ){ // skip blank lines
 
 				if( line[0] == '>' ){
@@ -114,7 +169,7 @@ int SequenceSet::readFASTA( bool singleStrand ){
                                 baseCounts[encoding[i]-1]++; // count base
 							}
 
-                            sequences_.push_back( new Sequence( encoding, L, header, Y_, singleStrand ) );
+                            sequences_.push_back( new Sequence( encoding, L, header, Y_, singleStrand, rng ) );
 
 							sequence.clear();
 							header.clear();
@@ -185,7 +240,7 @@ int SequenceSet::readFASTA( bool singleStrand ){
                     baseCounts[encoding[i]-1]++; // count base
                 }
 
-                sequences_.push_back( new Sequence( encoding, L, header, Y_, singleStrand ) );
+                sequences_.push_back( new Sequence( encoding, L, header, Y_, singleStrand, rng ) );
 
 				sequence.clear();
 				header.clear();
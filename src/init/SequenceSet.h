@@ -18,7 +18,8 @@ public:
 
 	SequenceSet( std::string sequenceFilepath,
 			bool singleStrand = false,
-			std::string intensityFilepath = "" );
+			std::string intensityFilepath = "",
+			Xoshiro256* rng = NULL );	// draws the letters for unknown letters, see Sequence
 	~SequenceSet();
 
 	std::string				getSequenceFilepath();
@@ -27,9 +28,13 @@ public:
 	size_t 					getMinL();
 	size_t					getMaxL();
 	float* 					getBaseFrequencies();
+	uint64_t				getHash();			// hash of the FASTA file content, see readFASTA()
 
 	void					print();			// print sequences
 
+	// hash of the content of a sequence set, e.g. the key of stores derived from it
+	static uint64_t			hashSequences( std::vector<Sequence*> seqs );
+
 private:
 
 	std::string				sequenceFilepath_;	// path to FASTA file
@@ -39,6 +44,7 @@ private:
 	size_t 					minL_;				// length of the shortest sequence
 	size_t 					maxL_;				// length of the longest sequence
 	float*	 				baseFrequencies_;	// kmer frequencies
+	uint64_t				hash_;				// key of stores derived from the set, e.g. background counts
 
 	std::vector<size_t>		Y_;					// contains 1 at position 0
 												// and the number of oligomers y for increasing order k at positions k+1
@@ -46,7 +52,7 @@ private:
 												// alphabet size_ = 4: Y_ = 4^0 4^1 4^2 ... 4^15 < std::numeric_limits<int>::max()
 												// limits the length of oligomers to 15 (and the order to 14)
 
-	int 					readFASTA( bool ss );// read in FASTA file
+	int 					readFASTA( bool ss, Xoshiro256* rng );// read in FASTA file
 	int 					readIntensities();	// read in intensity file
 };
 
@@ -3,14 +3,18 @@
 // This script is aimed to extract model probabilities from conditional probabilities in BaMM format
 // Input: file with suffix .ihbcp & .hbcp
 // Output: file with suffix .hbcp & .hbp
+// It also converts between the text and the binary BaMM format (.ihbb):
+// the models of a binary file are written as text files, and with --binary
+// one or more text files are written into a single binary file
 //
 
 #include "../init/Alphabet.h"
 #include "../init/BackgroundModel.h"
 #include "../init/Motif.h"
+#include "../init/MotifSet.h"
 #include "../refinement/utils.h"
 
-void constructBaMM( char* indir, char* odir, float** v_bg, size_t k_bg) {
+Motif* constructBaMM( char* indir, float** v_bg, size_t k_bg) {
     // each BaMM file contains one optimized motif model
     // read file to calculate motif length
     std::ifstream file;
@@ -60,11 +64,7 @@ void constructBaMM( char* indir, char* odir, float** v_bg, size_t k_bg) {
         // initialize motif from file
         motif->initFromBaMM(indir, 0, 0);
 
-        // write out the foreground model
-        motif->write( odir, baseName( indir ) );
-
-        if( motif )		delete motif;
-
+        return motif;
     }
 }
 
@@ -75,7 +75,10 @@ int main( int nargs, char* args[] ){
      */
     if( nargs < 3 ) {
         std::cerr << "Error: Arguments are missing!" << std::endl
-                  << "Usage: extractProbs <outdir> <bamm foreground model(.ihbcp)> <bamm background model(.hbcp)>"
+                  << "Usage: extractProbs <outdir> <bamm foreground model(.ihbcp/.ihbb)> <bamm background model(.hbcp)>"
+                  << std::endl
+                  << "       extractProbs <outdir> <bamm foreground model(.ihbcp)> <bamm background model(.hbcp)>"
+                  << " --binary [<more foreground models(.ihbcp)>]"
                   << std::endl;
         exit( 1 );
     }
@@ -102,8 +105,35 @@ int main( int nargs, char* args[] ){
     // save background model
     bgModel->write( outputDirectory, BgBasename );
 
-    // construct foreground model and save it
-    constructBaMM(BaMMFilename, outputDirectory, bgModel->getV(), bgModel->getOrder());
+    if( Motif::isBinary( BaMMFilename ) ){
+        // write each model of the binary file as text
+        MotifSet motif_set( BaMMFilename, 0, 0, "BaMM", NULL, bgModel->getV(), bgModel->getOrder() );
+        for( size_t n = 0; n < motif_set.getN(); n++ ){
+            std::string fileExtension = ( motif_set.getN() > 1 ) ? "_motif_" + std::to_string( n+1 ) : "";
+            motif_set.getMotifs()[n]->write( outputDirectory, baseName( BaMMFilename ) + fileExtension );
+        }
+
+    } else if( nargs > 4 and !strcmp( args[4], "--binary" ) ){
+        // write all given foreground models into one binary file
+        std::vector<Motif*> motifs;
+        std::vector<std::string> names;
+        motifs.push_back( constructBaMM( BaMMFilename, bgModel->getV(), bgModel->getOrder() ) );
+        names.push_back( baseName( BaMMFilename ) );
+        for( int i = 5; i < nargs; i++ ){
+            motifs.push_back( constructBaMM( args[i], bgModel->getV(), bgModel->getOrder() ) );
+            names.push_back( baseName( args[i] ) );
+        }
+        Motif::writeBinary( motifs, names, std::string( outputDirectory ) + '/' + names[0] + ".ihbb" );
+        for( size_t n = 0; n < motifs.size(); n++ ){
+            delete motifs[n];
+        }
+
+    } else {
+        // construct foreground model and save it
+        Motif* motif = constructBaMM( BaMMFilename, bgModel->getV(), bgModel->getOrder() );
+        motif->write( outputDirectory, baseName( BaMMFilename ) );
+        delete motif;
+    }
 
     return 0;
 }
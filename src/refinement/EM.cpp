@@ -138,15 +138,27 @@ int EM::optimize(){
 
 void EM::EStep(){
 
-    float llikelihood = 0.0f;
-
     motif_->calculateLinearS( bgModel_->getV(), K_bg_ );
 
-    // calculate responsibilities r at all LW1 positions on sequence n
-    // n runs over all sequences
+    // run the kernel specialized on the model order and alphabet
+    typedef float ( EM::*EStepKernelFn )();
+    static const EStepKernelFn kernels[] = { &EM::EStepKernel<0,0>,
+        &EM::EStepKernel<0,4>, &EM::EStepKernel<1,4>, &EM::EStepKernel<2,4>,
+        &EM::EStepKernel<3,4>, &EM::EStepKernel<4,4>, &EM::EStepKernel<5,4> };
+    llikelihood_ = ( this->*kernels[kmerKernel( K_, Y_[1] )] )();
+}
 
-#pragma omp parallel for reduction(+:llikelihood)
-    for( size_t n = 0; n < seqs_.size(); n++ ){
+template<size_t K, size_t A>
+float EM::EStepKernel(){
+
+    const size_t YK1 = ( A > 0 ) ? cpow( A, K+1 ) : Y_[K_+1];
+
+    // log likelihood of each sequence, summed up in sequence order
+    std::vector<float> llikelihoods( seqs_.size() );
+
+    // calculate responsibilities r at all LW1 positions on sequence n
+    // n runs over all sequences, see parallelFor() in utils.h
+    parallelFor( seqs_.size(), [&]( size_t n ){
 
         size_t 	L = seqs_[n]->getL();
         size_t 	LW1 = L - W_ + 1;
@@ -167,7 +179,7 @@ void EM::EStep(){
         for( size_t ij = 0; ij < LW1; ij++ ){
 
             // extract (K+1)-mer y from positions (ij-K,...,ij)
-            size_t y = kmer[ij] % Y_[K_+1];
+            size_t y = kmer[ij] % YK1;
 
             for( size_t j = 0; j < W_; j++ ){
                 r_[n][L-W_-ij+j] *= s_[y][j];
@@ -192,26 +204,10 @@ void EM::EStep(){
         }
 
         // calculate log likelihood over all sequences
-        llikelihood += logf( normFactor );
-    }
-
-    llikelihood_ = llikelihood;
+        llikelihoods[n] = logf( normFactor );
+    } );
 
-}
-
-// for parallelizing MStep()
-inline void atomic_float_add(float *source, const float operand) {
-    union {
-        unsigned int intVal;
-        float floatVal;
-    } newVal, prevVal;
-
-    do {
-        prevVal.floatVal = *source;
-        newVal.floatVal = prevVal.floatVal + operand;
-    } while (__atomic_compare_exchange_n( (volatile unsigned int *)source,
-                                          &prevVal.intVal, newVal.intVal, 0,
-                                          __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST) == false );
+    return std::accumulate( llikelihoods.begin(), llikelihoods.end(), 0.0f );
 }
 
 void EM::MStep(){
@@ -226,21 +222,20 @@ void EM::MStep(){
     }
 
     // compute fractional occurrence counts for the highest order K
-    // n runs over all sequences
-#pragma omp parallel for
-    for( size_t n = 0; n < seqs_.size(); n++ ){
-        size_t L = seqs_[n]->getL();
-        size_t* kmer = seqs_[n]->getKmer();
-
-        // ij = i+j runs over all positions i on sequence n
-        for( size_t ij = 0; ij < L-W_+1; ij++ ){
-            size_t y = kmer[ij] % Y_[K_+1];
-            for (size_t j = 0; j < W_; j++) {
-                // parallize for: n_[K_][y][j] += r_[n][L - W_ - ij + j];
-                atomic_float_add(&(n_[K_][y][j]), r_[n][L - W_ - ij + j]);
+    // j runs over the motif positions, each is summed up over all sequences n
+    // in sequence order, such that the counts do not depend on the threads
+    parallelFor( W_, [&]( size_t j ){
+        for( size_t n = 0; n < seqs_.size(); n++ ){
+            size_t L = seqs_[n]->getL();
+            size_t* kmer = seqs_[n]->getKmer();
+
+            // ij = i+j runs over all positions i on sequence n
+            for( size_t ij = 0; ij < L-W_+1; ij++ ){
+                size_t y = kmer[ij] % Y_[K_+1];
+                n_[K_][y][j] += r_[n][L - W_ - ij + j];
             }
         }
-    };
+    } );
 
     // compute fractional occurrence counts from higher to lower order
     // k runs over all lower orders
@@ -336,11 +331,10 @@ int EM::mask() {
         }
         pos_count += LW1;
     }
-    // Sort log odds scores in descending order
-    std::sort( r_all.begin(), r_all.end(), std::greater<float>() );
-
     // find the cutoff with f_% best r's
-    float r_cutoff = r_all[size_t((float)pos_count * f_)];
+    size_t r_rank = size_t( ( float )pos_count * f_ );
+    std::nth_element( r_all.begin(), r_all.begin() + r_rank, r_all.end(), std::greater<float>() );
+    float r_cutoff = r_all[r_rank];
 
     std::vector<std::vector<size_t>> ri;
     ri.resize( seqs_.size() );
@@ -385,14 +379,13 @@ int EM::mask() {
         /**
          * E-step for f_% motif occurrences
          */
-        float llikelihood = 0.0f;
+        std::vector<float> llikelihoods( seqs_.size() );
 
         motif_->calculateLinearS( bgModel_->getV(), K_bg_ );
 
         // calculate responsibilities r at all LW1 positions on sequence n
-        // n runs over all sequences
-#pragma omp parallel for reduction(+:llikelihood)
-        for( size_t n = 0; n < seqs_.size(); n++ ){
+        // n runs over all sequences, see parallelFor() in utils.h
+        parallelFor( seqs_.size(), [&]( size_t n ){
 
             size_t 	L = seqs_[n]->getL();
             size_t 	LW1 = L - W_ + 1;
@@ -429,10 +422,10 @@ int EM::mask() {
             }
 
             // calculate log likelihood over all sequences
-            llikelihood += logf( normFactor );
-        }
+            llikelihoods[n] = logf( normFactor );
+        } );
 
-        llikelihood_ = llikelihood;
+        llikelihood_ = std::accumulate( llikelihoods.begin(), llikelihoods.end(), 0.0f );
         /**
          * M-step for f_% motif occurrences
          */
@@ -576,9 +569,9 @@ void EM::write( char* odir, std::string basename, bool ss ){
 
 	// output position(s) of motif(s): pos_[n][i]
 	std::string opath_pos = opath + ".positions";
-	std::ofstream ofile_pos( opath_pos.c_str() );
+	RecordWriter ofile_pos( opath_pos );
 
-	ofile_pos << "seq\tlength\tstrand\tstart..end\tpattern" << std::endl;
+	ofile_pos.put( "seq\tlength\tstrand\tstart..end\tpattern\n" );
 
     float cutoff = 0.3f;	// threshold for having a motif on the sequence
                             // in terms of responsibilities
@@ -590,12 +583,12 @@ void EM::write( char* odir, std::string basename, bool ss ){
         for( size_t i = 0; i < seqs_[n]->getL()-W_+1; i++ ){
 
             if( r_[n][seqs_[n]->getL() -W_-i] >= cutoff ){
-                ofile_pos << seqs_[n]->getHeader() << '\t' << L << '\t'
-                          << ( ( i < L ) ? '+' : '-' ) << '\t' << i + 1 << ".." << i+W_ << '\t';
+                ofile_pos.put( seqs_[n]->getHeader() ).put( '\t' ).put( L ).put( '\t' )
+                         .put( ( i < L ) ? '+' : '-' ).put( '\t' ).put( i + 1 ).put( ".." ).put( i+W_ ).put( '\t' );
                 for( size_t b = i; b < i+W_; b++ ){
-                    ofile_pos << Alphabet::getBase( seqs_[n]->getSequence()[b] );
+                    ofile_pos.put( Alphabet::getBase( seqs_[n]->getSequence()[b] ) );
                 }
-                ofile_pos << std::endl;
+                ofile_pos.put( '\n' );
             }
         }
     }
@@ -7,6 +7,7 @@
 
 #include "../init/BackgroundModel.h"
 #include "../init/MotifSet.h"
+#include "../init/RecordWriter.h"
 
 class EM {
     /**
@@ -66,6 +67,12 @@ private:
     bool                    verbose_;           // show the output of each EM iteration
     std::vector<size_t>		Y_;
 
+                                                // the E-step for compile-time order K and alphabet
+                                                // size A, see kmerKernel() in utils.h; returns the
+                                                // log likelihood
+    template<size_t K, size_t A>
+    float                   EStepKernel();
+
 };
 
 #endif //EM_H_
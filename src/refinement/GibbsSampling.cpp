@@ -118,8 +118,8 @@ void GibbsSampling::optimize(){
     } else {
         // initialize z with a random number
         for( size_t n = 0; n < seqs_.size(); n++ ){
-            size_t LW2 = seqs_[n]->getL() - W_ + 2;
-            z_[n] = static_cast<size_t>( rand() ) % LW2;
+            std::uniform_int_distribution<size_t> range( 0, seqs_[n]->getL() - W_ + 1 );
+            z_[n] = range( rngx_ );
         }
     }
 
@@ -423,7 +423,8 @@ void GibbsSampling::Gibbs_sample_q(){
 
     // sampling the fraction of sequences which contain the motif
     boost::math::beta_distribution<float> q_beta_dist( ( float )seqs_.size() - ( float )N0_ + 1.0f, ( float )N0_ + 1.0f );
-    q_ = quantile( q_beta_dist, ( float )rand() / ( float )RAND_MAX );
+    std::uniform_real_distribution<float> uniform_dist( 0.0f, 1.0f );
+    q_ = quantile( q_beta_dist, uniform_dist( rngx_ ) );
 
 }
 
@@ -868,6 +869,11 @@ float GibbsSampling::calc_llikelihood_alphas( float** A, size_t k ){
 float GibbsSampling::getQ(){
     return q_;
 }
+
+void GibbsSampling::setSeed( size_t seed ){
+    rngx_.seed( static_cast<std::mt19937::result_type>( seed ) );
+}
+
 void GibbsSampling::print(){
 
     // print out motif parameter v
@@ -26,6 +26,8 @@ public:
 
     float                   getQ();             // get sampled positional prior q
 
+    void                    setSeed( size_t seed );	// seed the generator of all draws, 42 by default
+
 	void					print();			// print out optimized model v
 
 	void					write( char* odir, std::string basename, bool ss );
@@ -16,6 +16,7 @@ std::string			Global::negSequenceBasename;			// basename of negative sequence FA
 SequenceSet*        Global::negSequenceSet = NULL;			// negative sequence set
 bool				Global::negSeqGiven = false;			// a flag for the negative sequence given by users
 bool                Global::genericNeg = false;             // flag for generating negative sequences based on generic 2nd-bgModel
+bool                Global::kShuffle = false;               // flag for generating negative sequences by shuffling the positive sequences
 
 // weighting options
 char*               Global::intensityFilename = NULL;		// filename of intensity file (i.e. for HT-SELEX data)
@@ -44,6 +45,7 @@ bool                Global::interpolateBG = true;			// calculate prior probabili
 // background model options
 char*				Global::bgModelFilename = NULL;			// path to the background model file
 bool				Global::bgModelGiven = false;			// flag to show if the background model is given or not
+char*				Global::bgModelStore = NULL;			// directory of the background k-mer count store
 size_t				Global::bgModelOrder = 2;				// background model order, defaults to 2
 std::vector<float>	Global::bgModelAlpha( bgModelOrder+1, 1.f );// background model alpha
 
@@ -77,6 +79,7 @@ float 				Global::pvalCutoff = 0.0001f;			// score cutoff for printing log odds
 bool                Global::verbose = false;
 bool                Global::debugMode = false;              // debug-mode: prints out everything.
 bool				Global::saveBaMMs = true;
+bool				Global::saveBinaryBaMMs = false;
 bool				Global::savePRs = true;					// write the precision, recall, TP and FP
 bool				Global::savePvalues = false;			// write p-values for each log odds score from sequence set
 bool				Global::saveLogOdds = false;			// write the log odds of positive and negative sets to disk
@@ -250,6 +253,7 @@ int Global::readArguments( int nargs, char* args[] ){
 	if( opt >> GetOpt::Option( "bgModelFile", bgModelFilename ) ){
 		bgModelGiven = true;
 	}
+	opt >> GetOpt::Option( "bgModelStore", bgModelStore );
 
 	opt >> GetOpt::Option( 'K', "Order", bgModelOrder );
 
@@ -304,6 +308,7 @@ int Global::readArguments( int nargs, char* args[] ){
 		opt >> GetOpt::Option( 'm', "mFold", mFold );
 		opt >> GetOpt::Option( 'n', "cvFold", cvFold );
 		opt >> GetOpt::Option( 's', "sOrder", sOrder );
+		opt >> GetOpt::OptionPresent( "kShuffle", kShuffle );
 	}
 	// motif occurrence option
 	opt >> GetOpt::OptionPresent( "scoreSeqset", scoreSeqset );
@@ -313,6 +318,7 @@ int Global::readArguments( int nargs, char* args[] ){
 	opt >> GetOpt::OptionPresent( "verbose", verbose );
 	opt >> GetOpt::OptionPresent( "debug", debugMode );
 	opt >> GetOpt::OptionPresent( "saveBaMMs", saveBaMMs );
+	opt >> GetOpt::OptionPresent( "saveBinaryBaMMs", saveBinaryBaMMs );
 	opt >> GetOpt::OptionPresent( "saveInitialBaMMs", saveInitialBaMMs );
 	opt >> GetOpt::Option( "savePRs", savePRs );
 	opt >> GetOpt::OptionPresent( "savePvalues", savePvalues );
@@ -469,6 +475,11 @@ void Global::printHelp(){
 	printf("\n 			--bgModelFile <STRING> \n"
 			"				Read in background model from a bamm-formatted file.\n"
 			"				Defaults to NULL.\n\n");
+	printf("\n 			--bgModelStore <STRING> \n"
+			"				Directory of stored background k-mer counts. The counts\n"
+			"				of a sequence set are read from here if they were stored\n"
+			"				before with the same or a higher order, and are stored\n"
+			"				here otherwise. Defaults to NULL.\n\n");
 	printf("\n 		Options for EM: \n");
 	printf("\n 			--EM  \n"
 			"				Triggers Expectation Maximization (EM) algorithm.\n "
@@ -514,7 +525,10 @@ void Global::printHelp(){
 			"				4-fold of the test set.\n\n"
 			"			-s, --sOrder <INTERGER>\n"
 			"				The order of k-mer for sampling pseudo/negative set.\n"
-			"				The default is 2.\n\n");
+			"				The default is 2.\n\n"
+			"			--kShuffle\n"
+			"				Generate the negative set by shuffling the positive\n"
+			"				sequences, preserving their (s+1)-mer counts exactly.\n\n");
 	printf("\n 		Options for scoring sequence set:\n");
 	printf("\n 			--scoreSeqset \n"
 			"				Score the sequence set. \n\n");
@@ -526,6 +540,10 @@ void Global::printHelp(){
 			"				Verbose printouts.\n\n");
 	printf("\n 			--saveBaMMs\n"
 			"				Write optimized BaMM(s) parameters to disk.\n\n");
+	printf("\n 			--saveBinaryBaMMs\n"
+			"				Write the BaMM(s) also in binary format (.ihbb), which\n"
+			"				BaMMScan reads with --BaMMFile much faster. extractProbs\n"
+			"				converts between the text and the binary format.\n\n");
 	printf("\n 			--saveInitialBaMMs \n"
 			"				Save the initial BaMM model(s).\n\n");
 	printf("\n 			--savePRs\n"
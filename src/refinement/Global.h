@@ -41,6 +41,7 @@ public:
 	static SequenceSet*	negSequenceSet;			// negative sequence set
 	static bool			negSeqGiven;			// a flag for the negative sequence given by users
     static bool         genericNeg;             // flag for generating negative sequences based on generic 2nd-bgModel
+    static bool         kShuffle;               // flag for generating negative sequences by shuffling the positive sequences
 
 	// weighting options
 	static char*		intensityFilename;		// filename of intensity file (i.e. for HT-SELEX data)
@@ -72,6 +73,7 @@ public:
 	// background model options
     static char*		bgModelFilename;		// path to the background model file
     static bool			bgModelGiven;			// flag to show if the background model is given or not
+    static char*		bgModelStore;			// directory of the background k-mer count store
 	static size_t		bgModelOrder;			// background model order, defaults to 2
 	static std::vector<float> bgModelAlpha;		// background model alpha
 
@@ -103,6 +105,7 @@ public:
 	static bool			verbose;				// verbose printouts, defaults to false
 	static bool         debugMode;				// verbose printouts for debugging, defaults to false
 	static bool			saveBaMMs;				// write optimized BaMM(s) to disk
+	static bool			saveBinaryBaMMs;		// write the BaMM(s) also in binary format (.ihbb)
 	static bool			savePRs;				// write the precision, recall, TP and FP
 	static bool			savePvalues;			// write p-values for each log odds score from sequence set
 	static bool			saveLogOdds;			// write the log odds of positive and negative sets to disk
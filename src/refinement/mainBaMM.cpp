@@ -1,10 +1,15 @@
 #include <iomanip>
 #include <chrono>
 
+#ifdef OPENMP
+#include <omp.h>
+#endif
+
 #include "Global.h"
 #include "EM.h"
 #include "GibbsSampling.h"
 #include "../evaluation/FDR.h"
+#include "../seq_generator/BgSeqSource.h"
 
 int main( int nargs, char* args[] ){
 
@@ -40,7 +45,9 @@ int main( int nargs, char* args[] ){
                                        Global::bgModelOrder,
                                        Global::bgModelAlpha,
                                        Global::interpolateBG,
-                                       Global::outputFileBasename );
+                                       Global::outputFileBasename,
+                                       Global::bgModelStore,
+                                       Global::posSequenceSet->getHash() );
 
     } else {
 		bgModel = new BackgroundModel( Global::bgModelFilename );
@@ -96,27 +103,60 @@ int main( int nargs, char* args[] ){
 	}
 
     // sample negative sequence set B1set based on s-mer frequencies
-    // from positive training sequence set
-    std::vector<Sequence*>  negSet;
-    std::vector<std::unique_ptr<Sequence>> negSeqs;
+    // from positive training sequence set; the sequences are only
+    // generated when they are scored
     size_t minSeqN = 5000;
     bool rest = minSeqN % posSet.size();
     if( posSet.size() < minSeqN ){
         Global::mFold = minSeqN / posSet.size() + rest;
     }
 
-    SeqGenerator negseq( posSet, NULL, Global::sOrder, 1.0f, Global::genericNeg );
-    negSeqs = negseq.sample_bgseqset_by_fold( Global::mFold );
+    SeqGenerator negseq( posSet, NULL, Global::sOrder, 1.0f, Global::genericNeg, Global::kShuffle );
+    BgSeqSource negSource( &negseq, Global::mFold );
+
+    // Define bg model depending on motif input, and learning
+    // use bgModel generated from input sequences when prediction is turned on
+    BackgroundModel* bg = bgModel;
+    // if no optimization is applied, get bgModel from the input
+    if( Global::scoreSeqset and !Global::EM and !Global::CGS ) {
+        // use provided bgModelFile if initialized with bamm format
+        if( Global::initialModelTag == "BaMM" ) {
+            if( Global::bgModelFilename == NULL ) {
+                std::cout << "No background Model file provided for initial search motif!\n";
+                exit( 1 );
+            }
+            bg = new BackgroundModel( Global::bgModelFilename );
+        } else if( Global::initialModelTag == "PWM" ){
+            // this means that also the global motif order needs to be adjusted;
+            Global::modelOrder = 0;
+        }
+    }
 
-    // convert unique_ptr to regular pointer
-    for( size_t n = 0; n < negSeqs.size(); n++ ) {
-//        negSeqs[n]->print();    // print out negative sequences for checking
-        negSet.push_back( negSeqs[n].release() );
-        negSeqs[n].get_deleter();
+    /**
+     * Train the motifs concurrently: the threads are split between motifs
+     * and the loops over sequences within EM/CGS for each motif
+     */
+    size_t posL = 0;
+    for( size_t n = 0; n < posN; n++ ){
+        posL += posSet[n]->getL();
     }
+    size_t motifThreads, seqThreads;
+    splitThreads( Global::threads, motif_set.getN(), posL, motifThreads, seqThreads );
+
+#ifdef OPENMP
+    // the motifs start nested teams, the validation below runs as tasks
+    int maxLevels = omp_get_max_active_levels();
+    omp_set_max_active_levels( 2 );
+#endif
 
-//#pragma omp parallel for
+#pragma omp parallel for schedule(dynamic, 1) num_threads(motifThreads)
     for( size_t n = 0; n < motif_set.getN(); n++ ){
+
+#ifdef OPENMP
+        // number of threads for the nested loops of this motif
+        omp_set_num_threads( ( int )seqThreads );
+#endif
+
 		// deep copy each motif in the motif set
 		Motif* motif = new Motif( *motif_set.getMotifs()[n] );
 
@@ -144,11 +184,15 @@ int main( int nargs, char* args[] ){
 			}
 
             // print out the optimized q for checking:
+#pragma omp critical
             std::cout << "optimized q = " << model.getQ() << std::endl;
 
 		} else if ( Global::CGS ){
 			GibbsSampling model( motif, bgModel, posSet,
                                  !Global::noQSampling, Global::verbose );
+            // each motif draws from its own generator, seeded by its index,
+            // such that its model does not depend on the schedule
+            model.setSeed( 42 + n );
 			// learn motifs by collapsed Gibbs sampling
 			model.optimize();
 			// write model parameters on the disc
@@ -159,19 +203,26 @@ int main( int nargs, char* args[] ){
 			}
 
             // print out the optimized q for checking:
+#pragma omp critical
             std::cout << "optimized q = " << model.getQ() << std::endl;
 
 		} else {
+#pragma omp critical
 			std::cout << "Note: the model is not optimized!\n";
 		}
 
         // write out the (learned) foreground model
         motif->write( Global::outputDirectory,
                       Global::outputFileBasename + "_motif_" + std::to_string( n+1 ) );
+        if( Global::saveBinaryBaMMs ){
+            motif->writeBinary( Global::outputDirectory,
+                                Global::outputFileBasename + "_motif_" + std::to_string( n+1 ) );
+        }
 
         if( Global::scoreSeqset ){
             // score the model on sequence set
             if( Global::verbose ) {
+#pragma omp critical
                 std::cout << std::endl
                           << "*************************" << std::endl
                           << "*    Score Sequences    *" << std::endl
@@ -179,40 +230,32 @@ int main( int nargs, char* args[] ){
                           << std::endl;
             }
 
-            // Define bg model depending on motif input, and learning
-            // use bgModel generated from input sequences when prediction is turned on
-            BackgroundModel* bg = bgModel;
-            // if no optimization is applied, get bgModel from the input
-            if( !Global::EM and !Global::CGS ) {
-                // use provided bgModelFile if initialized with bamm format
-                if( Global::initialModelTag == "BaMM" ) {
-                    if( Global::bgModelFilename == NULL ) {
-                        std::cout << "No background Model file provided for initial search motif!\n";
-                        exit( 1 );
-                    }
-                    bg = new BackgroundModel( Global::bgModelFilename );
-                } else if( Global::initialModelTag == "PWM" ){
-                    // this means that also the global motif order needs to be adjusted;
-                    Global::modelOrder = 0;
-                }
-            }
+            ScoreSeqSet scoreNegSet( motif, bgModel, &negSource );
 
-            ScoreSeqSet scoreNegSet( motif, bgModel, negSet );
-            scoreNegSet.calcLogOdds();
+            size_t negAllN = 0;
+            for( size_t i = 0; i < negSource.getN(); i++ ){
+                negAllN += negSource.getL( i ) - motif->getW() + 1;
+            }
+            std::vector<float> negScores;
 
-            // print out log odds scores for checking before reranking
-            if( Global::saveLogOdds ){
+            // print out log odds scores for checking before reranking; as
+            // before, <basename>.negSet holds the scores of the last motif
+            if( Global::saveLogOdds and n+1 == motif_set.getN() ){
+                scoreNegSet.calcLogOdds();
                 scoreNegSet.writeLogOdds(Global::outputDirectory,
                                          Global::outputFileBasename + ".negSet",
                                          Global::ss );
-            }
-
-            std::vector<std::vector<float>> negAllScores = scoreNegSet.getMopsScores();
-            std::vector<float> negScores;
-            for( size_t n = 0; n < negSet.size(); n++ ){
-                negScores.insert( std::end( negScores ),
-                                  std::begin( negAllScores[n] ),
-                                  std::end( negAllScores[n] ) );
+                // take the scores just calculated instead of scoring again
+                std::vector<std::vector<float>> negAllScores = scoreNegSet.getMopsScores();
+                negScores.reserve( negAllN );
+                for( size_t i = 0; i < negAllScores.size(); i++ ){
+                    negScores.insert( std::end( negScores ),
+                                      std::begin( negAllScores[i] ),
+                                      std::end( negAllScores[i] ) );
+                }
+            } else {
+                negScores.resize( negAllN );
+                scoreNegSet.calcLogOdds( negScores.data(), NULL );
             }
 
             // calculate p-values based on positive and negative scores
@@ -239,6 +282,10 @@ int main( int nargs, char* args[] ){
         if( motif )		delete motif;
 	}
 
+#ifdef OPENMP
+    omp_set_max_active_levels( maxLevels );
+#endif
+
     // evaluate motifs
 	if( Global::FDR ){
 		if( Global::verbose ){
@@ -251,18 +298,25 @@ int main( int nargs, char* args[] ){
         /**
          * cross-validate the motif model
          */
-//#pragma omp parallel for
+        // each motif is a task which spawns one task per fold, all of them
+        // share the threads of one team, as do the loops within the folds
+
+#pragma omp parallel num_threads( Global::threads )
+#pragma omp single
         for( size_t n = 0; n < motif_set.getN(); n++ ){
-			Motif* motif = new Motif( *motif_set.getMotifs()[n] );
-			FDR fdr( posSet, negSet,
-                     motif, bgModel, Global::cvFold,
-                     Global::mops, Global::zoops,
-                     Global::savePRs, Global::savePvalues, Global::saveLogOdds );
-			fdr.evaluateMotif( Global::EM, Global::CGS, Global::optimizeQ, Global::advanceEM, Global::f );
-			fdr.write( Global::outputDirectory,
-                       Global::outputFileBasename + "_motif_" + std::to_string( n+1 ) );
-			if( motif )		delete motif;
-		}
+#pragma omp task firstprivate( n )
+            {
+                Motif* motif = new Motif( *motif_set.getMotifs()[n] );
+                FDR fdr( posSet, &negSource,
+                         motif, bgModel, Global::cvFold,
+                         Global::mops, Global::zoops,
+                         Global::savePRs, Global::savePvalues, Global::saveLogOdds );
+                fdr.evaluateMotif( Global::EM, Global::CGS, Global::optimizeQ, Global::advanceEM, Global::f, Global::threads );
+                fdr.write( Global::outputDirectory,
+                           Global::outputFileBasename + "_motif_" + std::to_string( n+1 ) );
+                if( motif )		delete motif;
+            }
+        }
 
     }
 
@@ -277,6 +331,7 @@ int main( int nargs, char* args[] ){
     std::cout << std::endl << "------ Runtime: " << t_diff.count() <<" seconds -------" << std::endl;
 
 	// free memory
+	if( bg != bgModel ) delete bg;
 	if( bgModel ) delete bgModel;
 
 	Global::destruct();
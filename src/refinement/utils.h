@@ -8,8 +8,15 @@
 #include <memory>
 #include <utility>
 
+#include <math.h>		// e.g. rintf
+#include <stdint.h>		// e.g. uint64_t
+#include <string.h>		// e.g. memcpy
 #include <sys/stat.h>	// e.g. stat
 
+#ifdef OPENMP
+#include <omp.h>
+#endif
+
 #ifndef M_GAMMAl
 /** Euler's constant in high precision */
 #define M_GAMMAl 0.5772156649015328606065120900824024L
@@ -57,12 +64,37 @@ static void					createDirectory( char* dir );
 // calculate the power for integer base
 static size_t				ipow( size_t base, size_t exp );
 
+// the same at compile time, e.g. the number A^(K+1) of (K+1)-mers in kernels for
+// compile-time K and A, where the modulo by it becomes a mask for A = 4
+constexpr size_t			cpow( size_t base, size_t exp );
+
+// index of the kernel instance for order K and alphabet size A in a table of
+// { kernel<0,0>, kernel<0,4>, ..., kernel<5,4> }, where the instance with A = 0
+// takes the order and alphabet at runtime
+inline size_t				kmerKernel( size_t K, size_t A );
+
+// convert to IEEE 754 half precision, rounding to nearest even
+static uint16_t				floatToHalf( float x );
+
+// split threads between independent jobs (outer) and the parallel loops within each job (inner)
+static void                 splitThreads( size_t threads, size_t nJobs, size_t workload,
+                                          size_t& outer, size_t& inner );
+
 // concatenate two strings by leaving out the overlapped characters
 static std::string          concatenate2strings( std::string s1, std::string s2 );
 
 // returns a permutation which rearranges v into ascending order
 template <typename T> std::vector<size_t> sortIndices( const std::vector<T> &v );
 
+// run f( i ) for i = 0, ..., n-1 as OpenMP tasks
+template <typename Function> void runTasks( size_t n, Function f );
+
+// sort v according to comp using all threads
+template <typename T, typename Compare> void parallelSort( std::vector<T>& v, Compare comp );
+
+// merge the sorted runs [bounds[r], bounds[r+1]) of v pairwise into one sorted vector
+template <typename T, typename Compare> void mergeSortedRuns( std::vector<T>& v, std::vector<size_t> bounds, Compare comp );
+
 inline std::string baseName( const char* filePath ){
 
 	size_t i = 0, start = 0, end = 0;
@@ -178,6 +210,186 @@ inline size_t ipow( size_t base, size_t exp ){
     return res;
 }
 
+constexpr size_t cpow( size_t base, size_t exp ){
+	return ( exp == 0 ) ? 1 : base * cpow( base, exp-1 );
+}
+
+inline size_t kmerKernel( size_t K, size_t A ){
+	return ( A == 4 and K <= 5 ) ? K+1 : 0;
+}
+
+inline uint16_t floatToHalf( float x ){
+
+	uint32_t f;
+	memcpy( &f, &x, sizeof( f ) );
+
+	uint16_t sign = static_cast<uint16_t>( ( f >> 16 ) & 0x8000 );
+	uint32_t absf = f & 0x7FFFFFFF;
+
+	if( absf > 0x7F800000 ){
+		// NaN
+		return sign | 0x7E00;
+	}
+	if( absf >= 0x477FF000 ){
+		// overflows, from 65520 on
+		return sign | 0x7C00;
+	}
+	if( absf < 0x38800000 ){
+		// subnormal, below 2^-14: multiples of 2^-24
+		float a;
+		memcpy( &a, &absf, sizeof( a ) );
+		return sign | static_cast<uint16_t>( rintf( a * 16777216.0f ) );
+	}
+
+	uint32_t h = ( ( ( absf >> 23 ) - 112 ) << 10 ) | ( ( absf >> 13 ) & 0x3FF );
+	uint32_t rest = absf & 0x1FFF;
+	if( rest > 0x1000 || ( rest == 0x1000 && ( h & 1 ) ) ){
+		h++;
+	}
+	return sign | static_cast<uint16_t>( h );
+}
+
+inline void splitThreads( size_t threads, size_t nJobs, size_t workload,
+                          size_t& outer, size_t& inner ){
+
+    /**
+     * workload is the number of sequence positions a single job loops over.
+     * Jobs are spread over the threads first, as they run without any
+     * synchronisation. The remaining threads go to the loops over sequences
+     * within a job, but only as many as can be kept busy: for small inputs
+     * the fork/join overhead of the inner loops dominates.
+     */
+
+    size_t minPositionsPerThread = 50000;               // minimal work for an inner thread
+    size_t maxBytesInFlight = size_t( 4 ) << 30;        // memory for concurrently running jobs
+
+    threads = std::max( threads, size_t( 1 ) );
+    nJobs   = std::max( nJobs, size_t( 1 ) );
+    workload= std::max( workload, size_t( 1 ) );
+
+    // each EM job allocates responsibilities and positional priors for all positions
+    size_t maxOuter = std::max( size_t( 1 ), maxBytesInFlight / ( 2 * sizeof( float ) * workload ) );
+    outer = std::min( std::min( threads, nJobs ), maxOuter );
+
+    size_t maxInner = std::max( size_t( 1 ), workload / minPositionsPerThread );
+    inner = std::min( std::max( threads / outer, size_t( 1 ) ), maxInner );
+}
+
+inline bool inTaskPool(){
+
+	/**
+	 * inside a parallel region which cannot start a nested team, e.g. in the
+	 * task of a motif or fold in FDR, parallel work is run as tasks on the
+	 * pool of the enclosing team, such that its idle threads join in; a team
+	 * which can nest, e.g. of the motifs in BaMMmotif, starts nested teams
+	 */
+	bool asTasks = false;
+#ifdef OPENMP
+	asTasks = omp_in_parallel() and omp_get_active_level() >= omp_get_max_active_levels();
+#endif
+	return asTasks;
+}
+
+template <typename Function> inline void runTasks( size_t n, Function f ){
+
+	// tasks of the enclosing team, see inTaskPool(), or of a new team
+	if( inTaskPool() ){
+		for( size_t i = 0; i < n; i++ ){
+#pragma omp task firstprivate( i ) shared( f )
+			f( i );
+		}
+#pragma omp taskwait
+	} else {
+#pragma omp parallel
+#pragma omp single
+		for( size_t i = 0; i < n; i++ ){
+#pragma omp task firstprivate( i ) shared( f )
+			f( i );
+		}
+	}
+}
+
+template <typename Function> inline void parallelFor( size_t n, Function f ){
+
+	// a task loop on the enclosing team, see inTaskPool(), or a parallel loop
+	if( inTaskPool() ){
+#pragma omp taskloop shared( f )
+		for( size_t i = 0; i < n; i++ ){
+			f( i );
+		}
+	} else {
+#pragma omp parallel for
+		for( size_t i = 0; i < n; i++ ){
+			f( i );
+		}
+	}
+}
+
+// the number of threads which run the tasks or the loops of parallelFor()
+inline size_t poolThreads(){
+	size_t threads = 1;
+#ifdef OPENMP
+	threads = inTaskPool() ? omp_get_num_threads() : omp_get_max_threads();
+#endif
+	return threads;
+}
+
+template <typename T, typename Compare> inline void parallelSort( std::vector<T>& v, Compare comp ){
+
+	size_t threads = poolThreads();
+
+	// split v into one run per thread, but not into runs too short to pay off
+	size_t minRunLength = 1 << 16;
+	size_t nRuns = std::min( threads, v.size() / minRunLength );
+	if( nRuns < 2 ){
+		std::sort( v.begin(), v.end(), comp );
+		return;
+	}
+
+	std::vector<size_t> bounds( nRuns+1 );
+	for( size_t r = 0; r <= nRuns; r++ ){
+		bounds[r] = v.size() * r / nRuns;
+	}
+
+	runTasks( nRuns, [&]( size_t r ){
+		std::sort( v.begin() + bounds[r], v.begin() + bounds[r+1], comp );
+	} );
+
+	mergeSortedRuns( v, bounds, comp );
+}
+
+template <typename T, typename Compare> inline void mergeSortedRuns( std::vector<T>& v, std::vector<size_t> bounds, Compare comp ){
+
+	std::vector<T> buffer( v.size() );
+
+	// merge neighbouring runs until a single run is left
+	while( bounds.size() > 2 ){
+
+		size_t nRuns = bounds.size() - 1;
+
+		runTasks( nRuns / 2, [&]( size_t p ){
+			std::merge( v.begin() + bounds[2*p], v.begin() + bounds[2*p+1],
+						v.begin() + bounds[2*p+1], v.begin() + bounds[2*p+2],
+						buffer.begin() + bounds[2*p], comp );
+		} );
+
+		// an odd run is left over
+		if( nRuns % 2 ){
+			std::copy( v.begin() + bounds[nRuns-1], v.begin() + bounds[nRuns],
+					   buffer.begin() + bounds[nRuns-1] );
+		}
+
+		v.swap( buffer );
+
+		std::vector<size_t> merged;
+		for( size_t r = 0; r < nRuns; r += 2 ){
+			merged.push_back( bounds[r] );
+		}
+		merged.push_back( bounds[nRuns] );
+		bounds.swap( merged );
+	}
+}
+
 template <typename T> inline std::vector<size_t> sortIndices( const std::vector<T>& v ){
 
   // initialize with original indices
@@ -377,6 +589,48 @@ struct deleter{
     };
 };
 
+/**
+ * xoshiro256+ generator by Blackman and Vigna, for inner loops which
+ * draw one random number per sequence position. The state is filled by
+ * splitmix64 from a seed and a stream number, so that e.g. each generated
+ * sequence gets its own reproducible stream.
+ */
+class Xoshiro256{
+
+public:
+
+	Xoshiro256( uint64_t seed, uint64_t stream = 0 ){
+		uint64_t x = seed;
+		x = splitmix64( x ) ^ stream;
+		for( size_t i = 0; i < 4; i++ ){
+			s_[i] = splitmix64( x );
+		}
+	}
+
+	uint64_t operator()(){
+		uint64_t result = s_[0] + s_[3];
+		uint64_t t = s_[1] << 17;
+		s_[2] ^= s_[0];
+		s_[3] ^= s_[1];
+		s_[1] ^= s_[2];
+		s_[0] ^= s_[3];
+		s_[2] ^= t;
+		s_[3] = ( s_[3] << 45 ) | ( s_[3] >> 19 );
+		return result;
+	}
+
+private:
+
+	static uint64_t splitmix64( uint64_t& x ){
+		uint64_t z = ( x += 0x9E3779B97F4A7C15ULL );
+		z = ( z ^ ( z >> 30 ) ) * 0xBF58476D1CE4E5B9ULL;
+		z = ( z ^ ( z >> 27 ) ) * 0x94D049BB133111EBULL;
+		return z ^ ( z >> 31 );
+	}
+
+	uint64_t	s_[4];
+};
+
 namespace util
 {
 #if __cplusplus == 201402L // C++14
@@ -0,0 +1,52 @@
+#include "BgSeqSource.h"
+
+BgSeqSource::BgSeqSource( SeqGenerator* generator, size_t fold ){
+
+	generator_	= generator;
+	fold_		= fold;
+	N_			= generator_->getRefN() * fold_;
+	maxL_		= 0;
+	for( size_t i = 0; i < generator_->getRefN(); i++ ){
+		maxL_ = std::max( maxL_, generator_->getRefL( i ) );
+	}
+
+	generator_->calculate_kmer_frequency();
+	// the sequences of a reference are not always generated in one run, e.g.
+	// by FDR, which scores every cvFold-th sequence in each fold
+	generator_->cache_rescaled_tables( 64 << 20 );
+}
+
+BgSeqSource::BgSeqSource( SeqGenerator* generator, size_t N, size_t L ){
+
+	generator_	= generator;
+	fold_		= 0;
+	N_			= N;
+	maxL_		= L;
+
+	generator_->calculate_kmer_frequency();
+}
+
+size_t BgSeqSource::getN(){
+	return N_;
+}
+
+size_t BgSeqSource::getL( size_t n ){
+	return ( fold_ > 0 ) ? generator_->getRefL( n / fold_ ) : maxL_;
+}
+
+size_t BgSeqSource::getMaxL(){
+	return maxL_;
+}
+
+std::string BgSeqSource::getHeader( size_t n ){
+	return "> bg_seq";
+}
+
+void BgSeqSource::generate( size_t n, uint8_t* sequence, size_t* kmer ){
+
+	if( fold_ > 0 ){
+		generator_->sample_bgseq_by_fold( n, fold_, sequence, kmer );
+	} else {
+		generator_->sample_bgseq_by_num( n, maxL_, sequence, kmer );
+	}
+}
@@ -0,0 +1,38 @@
+#ifndef BGSEQSOURCE_H_
+#define BGSEQSOURCE_H_
+
+#include "../init/SeqSource.h"
+#include "SeqGenerator.h"
+
+class BgSeqSource : public SeqSource {
+
+	/*
+	 * Background sequence set which is generated lazily by a SeqGenerator:
+	 * sequence n is drawn from its own random number stream, so it equals
+	 * the n-th sequence of sample_bgseqset_by_fold() or
+	 * sample_bgseqset_by_num() without keeping the whole set in memory.
+	 */
+
+public:
+
+	// fold sequences for each input sequence of the generator
+	BgSeqSource( SeqGenerator* generator, size_t fold );
+	// N sequences of length L
+	BgSeqSource( SeqGenerator* generator, size_t N, size_t L );
+
+	size_t	getN();
+	size_t	getL( size_t n );
+	size_t	getMaxL();
+	std::string	getHeader( size_t n );
+
+	void	generate( size_t n, uint8_t* sequence, size_t* kmer );
+
+private:
+
+	SeqGenerator*		generator_;
+	size_t				fold_;			// 0 when sequences are sampled by number
+	size_t				N_;
+	size_t				maxL_;
+};
+
+#endif /* BGSEQSOURCE_H_ */
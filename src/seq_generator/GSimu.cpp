@@ -34,6 +34,7 @@ std::vector<float>  GSimu::bgModelAlpha( bgModelOrder+1, 1.f );// background mod
 size_t		        GSimu::mFold = 10;					// number of negative sequences as multiple of positive sequences
 size_t		        GSimu::sOrder = 2;					// k-mer order for sampling negative sequence set
 bool                GSimu::sampleBgset = false;
+bool                GSimu::kShuffle = false;
 bool                GSimu::maskSeqset = false;
 bool                GSimu::embedSeqset = false;
 size_t              GSimu::at = 0;                      // default embedding position as 0, later it will be randomized
@@ -169,6 +170,8 @@ int GSimu::readArguments( int nargs, char* args[] ){
             sOrder = std::stoi( args[i] );
         } else if( !strcmp( args[i], "--sampleBgset" ) ){
             sampleBgset = true;
+        } else if( !strcmp( args[i], "--kShuffle" ) ){
+            kShuffle = true;
         } else if( !strcmp( args[i], "--maskSeqset" ) ){
             maskSeqset = true;
         } else if( !strcmp( args[i], "--embedSeqset" ) ){
@@ -229,6 +232,10 @@ void GSimu::printHelp(){
     printf("\n 			--sampleBgset\n"
                    "				Sample background sequence set based on s-mer frequencies \n"
                    "				from the input sequence set. Defaults to false.\n\n");
+    printf("\n 			--kShuffle\n"
+                   "				Sample the background sequence set by shuffling the input\n"
+                   "				sequences, preserving their (s+1)-mer counts exactly.\n"
+                   "				Defaults to false.\n\n");
     printf("\n 			--maskSeqset\n"
                    "				Mask the given motif from the input sequence set.\n"
                    "				Defaults to false.\n\n");
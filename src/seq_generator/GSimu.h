@@ -41,6 +41,7 @@ public:
     static size_t		mFold;					// number of sampled sequences as multiple of input sequences
     static size_t		sOrder;					// k-mer order for sampling negative sequence set
     static bool         sampleBgset;
+    static bool         kShuffle;               // shuffle the input sequences instead of sampling them
     static bool         maskSeqset;
     static bool         embedSeqset;
     static size_t       at;                     // position for embedding the motif
@@ -1,28 +1,85 @@
 #include "SeqGenerator.h"
 
-SeqGenerator::SeqGenerator( std::vector<Sequence*> seqs, Motif* motif, size_t sOrder, float q, bool genericNeg ){
+#include <atomic>
+
+namespace {
+
+/**
+ * Per-thread tables of the model rescaled to the reference sequence that
+ * was used last. Sequences generated on demand mostly come in runs with
+ * the same reference sequence, which then is rescaled only once.
+ */
+struct RescaledTables{
+
+	size_t		owner = 0;		// id of the generator the tables belong to, 0 if unused
+	size_t		ref = 0;		// index of the reference sequence
+	size_t		sOrder = 0;
+	size_t**	n_seq = NULL;
+	float**		v_seq = NULL;
+	float**		range_bar = NULL;
+	float**		aliasProb = NULL;
+	uint8_t**	alias = NULL;
+
+	void release(){
+		if( owner == 0 ) return;
+		for( size_t k = 0; k < sOrder+1; k++ ){
+			free( n_seq[k] );
+			free( v_seq[k] );
+			free( range_bar[k] );
+			free( aliasProb[k] );
+			free( alias[k] );
+		}
+		free( n_seq );
+		free( v_seq );
+		free( range_bar );
+		free( aliasProb );
+		free( alias );
+		owner = 0;
+	}
+
+	~RescaledTables(){
+		release();
+	}
+};
+
+thread_local RescaledTables rescaledTables;
 
+std::atomic<size_t> generatorCount( 0 );
+
+}
+
+SeqGenerator::SeqGenerator( std::vector<Sequence*> seqs, Motif* motif, size_t sOrder, float q, bool genericNeg, bool kShuffle ){
+
+	id_ = ++generatorCount;
 	seqs_ = seqs;
 	sOrder_ = sOrder;
     motif_ = motif;
     q_ = q;
     genericNeg_ = genericNeg;
+    kShuffle_ = kShuffle;
+
+    // the k-mer arrays of sequences hold up to 11-mers
+    if( sOrder_ > 10 ){
+        std::cerr << "Error: the order of k-mers for sampling sequences cannot exceed 10." << std::endl;
+        exit( 1 );
+    }
 
-	for( size_t k = 0; k < sOrder_ + 8; k++ ){
+	// at least up to the 11-mers stored in the k-mer arrays of sequences
+	for( size_t k = 0; k < std::max( sOrder_ + 8, size_t( 12 ) ); k++ ){
 		Y_.push_back( ipow( Alphabet::getSize(), k ) );
 	}
 
     v_ = ( float** )calloc( sOrder_+1, sizeof( float* ) );
 	n_ = ( size_t** )calloc( sOrder_+1, sizeof( size_t* ) );
     range_bar_ = ( float** )calloc( sOrder_+1, sizeof( float* ) );
-    v_seq_ = ( float** )calloc( sOrder_+1, sizeof( float* ) );
-    n_seq_ = ( size_t** )calloc( sOrder_+1, sizeof( size_t* ) );
+    aliasProb_ = ( float** )calloc( sOrder_+1, sizeof( float* ) );
+    alias_ = ( uint8_t** )calloc( sOrder_+1, sizeof( uint8_t* ) );
 	for( size_t k = 0; k < sOrder_+1; k++ ) {
         v_[k] = (float *) calloc(Y_[k + 1], sizeof(float));
         n_[k] = (size_t *) calloc(Y_[k + 1], sizeof(size_t));
         range_bar_[k] = (float *) calloc(Y_[k + 1], sizeof(float));
-        v_seq_[k] = (float *) calloc(Y_[k + 1], sizeof(float));
-        n_seq_[k] = (size_t *) calloc(Y_[k + 1], sizeof(size_t));
+        aliasProb_[k] = (float *) calloc(Y_[k + 1], sizeof(float));
+        alias_[k] = (uint8_t *) calloc(Y_[k + 1], sizeof(uint8_t));
     }
 
     A_ = ( float* )calloc( sOrder_+1, sizeof( float ) );
@@ -30,11 +87,11 @@ SeqGenerator::SeqGenerator( std::vector<Sequence*> seqs, Motif* motif, size_t sO
         A_[k] = 20.f;
     }
 
-    rngx_.seed( 42 );
+    seed_ = 42;
+    rngx_.seed( seed_ );
     srand( 42 );
 
     kmer_freq_is_calculated_ = false;
-    kmer_freq_is_rescaled_ = false;
 
     N_ = seqs_.size();
 
@@ -46,15 +103,15 @@ SeqGenerator::~SeqGenerator(){
         free( v_[k] );
 		free( n_[k] );
         free( range_bar_[k] );
-        free( v_seq_[k] );
-        free( n_seq_[k] );
+        free( aliasProb_[k] );
+        free( alias_[k] );
 	}
 
     free( v_ );
 	free( n_ );
     free( range_bar_ );
-    free( v_seq_ );
-	free( n_seq_ );
+    free( aliasProb_ );
+    free( alias_ );
 
     free( A_ );
 
@@ -71,17 +128,9 @@ void SeqGenerator::calculate_kmer_frequency(){
 
 	// count k-mers
 	for( size_t i = 0; i < seqs_.size(); i++ ){
-		size_t L = seqs_[i]->getL();
-		size_t* kmer = seqs_[i]->getKmer();
-		for( size_t k = 0; k < sOrder_+1; k++ ){
-			for( size_t j = k; j < L; j++ ){
-				// extract (k+1)-mer
-				size_t y = kmer[j] % Y_[k+1];
-				// count (k+1)mer
-				n_[k][y]++;
-			}
-		}
+		count_kmers( seqs_[i], n_ );
 	}
+	marginalize_kmer_counts( n_ );
 
 	// calculate frequencies
 	size_t normFactor = 0;
@@ -108,97 +157,199 @@ void SeqGenerator::calculate_kmer_frequency(){
             range_bar_[k][y] = sum;
 		}
 	}
+    build_alias_tables( range_bar_, aliasProb_, alias_ );
+
     kmer_freq_is_calculated_ = true;
 }
 
-void SeqGenerator::rescale_kmer_frequency( Sequence* refSeq ) {
+void SeqGenerator::rescale_kmer_frequency( Sequence* refSeq, size_t** n_seq, float** v_seq, float** range_bar ) {
 
     size_t L = refSeq->getL();
     // count k-mers for each sequence
     // reset counts for k-mers
     for( size_t k = 0; k < sOrder_+1; k++ ){
         for( size_t y = 0; y < Y_[k+1]; y++ ){
-            n_seq_[k][y] = 0;
+            n_seq[k][y] = 0;
         }
     }
     // count k-mers
-    size_t* kmer = refSeq->getKmer();
-    for( size_t k = 0; k < sOrder_+1; k++ ){
-        // loop over sequence positions
-        for( size_t j = k; j < L; j++ ){
-            // extract (k+1)-mer
-            size_t y = kmer[j] % Y_[k+1];
-            // count (k+1)mer
-            n_seq_[k][y]++;
-        }
-    }
+    count_kmers( refSeq, n_seq );
+    marginalize_kmer_counts( n_seq );
 
     // calculate sequence-specific conditional probabilities
     // when k = 0:
     size_t k =0;
     float sum = 0.f;
     for( size_t y = 0; y < Y_[k+1]; y++ ){
-        v_seq_[k][y] = v_[k][y];
-        sum += v_seq_[k][y];
-        range_bar_[k][y] = sum;
+        v_seq[k][y] = v_[k][y];
+        sum += v_seq[k][y];
+        range_bar[k][y] = sum;
     }
 
+    if( sOrder_ < 1 ) return;
+
     // when k = 1:
     k = 1;
 
     for( size_t y = 0; y < Y_[k+1]; y++ ){
         size_t y2 = y % Y_[k];
-        v_seq_[k][y] = v_[k][y] * ( n_seq_[k][y] + A_[k-1] * v_[k-1][y2] ) / v_[k-1][y2] / ( L + A_[k-1] );
+        v_seq[k][y] = v_[k][y] * ( n_seq[k][y] + A_[k-1] * v_[k-1][y2] ) / v_[k-1][y2] / ( L + A_[k-1] );
     }
     // re-scale 1st-order background model
     std::vector<float> normFactors( Y_[k], 0.0f );
     for( size_t y = 0; y < Y_[k+1]; y++ ){
         size_t yk = y / Y_[1];
-        v_seq_[k][y] = ( n_seq_[k][y] + A_[k] * v_seq_[k][y] ) / ( n_seq_[k-1][yk] + A_[k] );
-        normFactors[yk] += v_seq_[k][y];
+        v_seq[k][y] = ( n_seq[k][y] + A_[k] * v_seq[k][y] ) / ( n_seq[k-1][yk] + A_[k] );
+        normFactors[yk] += v_seq[k][y];
     }
     // normalization:
     for( size_t y = 0; y < Y_[k+1]; y++ ){
         size_t yk = y / Y_[1];
-        v_seq_[k][y] /= normFactors[yk];
+        v_seq[k][y] /= normFactors[yk];
     }
 
     for( size_t y = 0; y < Y_[k+1]; y++ ){
         if( y % Y_[1] == 0 )    sum = 0.0f;
-        sum += v_seq_[k][y];
-        range_bar_[k][y] = sum;
+        sum += v_seq[k][y];
+        range_bar[k][y] = sum;
     }
 
-    // for k= 2:
-    k = 2;
-    // re-scale 2nd-order background model
-    for( size_t y = 0; y < Y_[k+1]; y++ ){
-        size_t y2 = y % Y_[k];
-        size_t yk = y / Y_[1];
-        v_seq_[k][y] = ( n_seq_[k][y] + A_[k] * v_seq_[k-1][y2] ) / ( n_seq_[k-1][yk] + A_[k] );
-        if( y % Y_[1] == 0 ) sum = 0.0f;
-        sum += v_seq_[k][y];
-        range_bar_[k][y] = sum;
+    // for k >= 2:
+    // re-scale the higher-order background models on the next lower order
+    for( k = 2; k < sOrder_+1; k++ ){
+        for( size_t y = 0; y < Y_[k+1]; y++ ){
+            size_t y2 = y % Y_[k];
+            size_t yk = y / Y_[1];
+            v_seq[k][y] = ( n_seq[k][y] + A_[k] * v_seq[k-1][y2] ) / ( n_seq[k-1][yk] + A_[k] );
+            if( y % Y_[1] == 0 ) sum = 0.0f;
+            sum += v_seq[k][y];
+            range_bar[k][y] = sum;
+        }
     }
 
-    kmer_freq_is_rescaled_ = true;
+}
+
+// count the (sOrder+1)-mers of seq at all positions, and the lower-order
+// k-mers only at the positions no (sOrder+1)-mer ends at
+void SeqGenerator::count_kmers( Sequence* seq, size_t** n ){
+
+	size_t L = seq->getL();
+	size_t* kmer = seq->getKmer();
+
+	for( size_t j = sOrder_; j < L; j++ ){
+		n[sOrder_][kmer[j] % Y_[sOrder_+1]]++;
+	}
+	for( size_t k = 0; k < std::min( sOrder_, L ); k++ ){
+		n[k][kmer[k] % Y_[k+1]]++;
+	}
+}
+
+// complete the counts of count_kmers() by summing up the counts of the next higher order
+void SeqGenerator::marginalize_kmer_counts( size_t** n ){
+
+	for( size_t k = sOrder_; k > 0; k-- ){
+		for( size_t y = 0; y < Y_[k+1]; y++ ){
+			n[k-1][y % Y_[k]] += n[k][y];
+		}
+	}
+}
+
+// build the alias tables of all contexts from the cumulated k-mer frequencies range_bar
+void SeqGenerator::build_alias_tables( float** range_bar, float** aliasProb, uint8_t** alias ){
+
+	size_t A = Y_[1];
+	std::vector<float> p( A );
+	std::vector<size_t> small, large;
+
+	for( size_t k = 0; k < sOrder_+1; k++ ){
+		for( size_t yk = 0; yk < Y_[k+1]; yk += A ){
+
+			// probabilities as drawn by walking through range_bar: the last
+			// letter takes whatever is left of the unit interval
+			float sum = 0.0f;
+			for( size_t a = 0; a < A; a++ ){
+				float upper = ( a+1 < A ) ? range_bar[k][yk+a] : 1.0f;
+				float lower = ( a > 0 ) ? range_bar[k][yk+a-1] : 0.0f;
+				p[a] = std::max( upper - lower, 0.0f );
+				sum += p[a];
+			}
+
+			// Vose's method: pair each under-full column with an over-full one
+			small.clear();
+			large.clear();
+			for( size_t a = 0; a < A; a++ ){
+				p[a] = p[a] * A / sum;
+				( p[a] < 1.0f ? small : large ).push_back( a );
+			}
+			while( !small.empty() && !large.empty() ){
+				size_t s = small.back(); small.pop_back();
+				size_t l = large.back();
+				aliasProb[k][yk+s] = p[s];
+				alias[k][yk+s] = ( uint8_t )l;
+				p[l] -= 1.0f - p[s];
+				if( p[l] < 1.0f ){
+					large.pop_back();
+					small.push_back( l );
+				}
+			}
+			// left-overs are full columns up to rounding
+			for( size_t a : small ){
+				aliasProb[k][yk+a] = 1.0f;
+				alias[k][yk+a] = ( uint8_t )a;
+			}
+			for( size_t a : large ){
+				aliasProb[k][yk+a] = 1.0f;
+				alias[k][yk+a] = ( uint8_t )a;
+			}
+		}
+	}
 }
 
 // generate negative sequences based on k-mer frequencies, given m-fold
 std::vector<std::unique_ptr<Sequence>> SeqGenerator::sample_bgseqset_by_fold(size_t fold){
 
-	std::vector<std::unique_ptr<Sequence>> negset;
+	std::vector<std::unique_ptr<Sequence>> negset( seqs_.size() * fold );
 
 	calculate_kmer_frequency();
-    // todo: can be parallised
-	for( size_t i = 0; i < seqs_.size(); i++ ){
-		for( size_t n = 0; n < fold; n++ ){
-            if( genericNeg_ ){
-                negset.push_back( bg_sequence( seqs_[i]->getL() ) );
-            } else {
-                negset.push_back( bgseq_on_rescaled_v(seqs_[i]) );
-            }
+
+#pragma omp parallel
+	{
+		// thread-local tables for the model rescaled to each reference sequence
+		size_t** n_seq;
+		float** v_seq;
+		float** range_bar;
+		float** aliasProb;
+		uint8_t** alias;
+		calloc_rescaled_tables( n_seq, v_seq, range_bar, aliasProb, alias );
+
+#pragma omp for schedule( dynamic, 16 )
+		for( size_t i = 0; i < seqs_.size(); i++ ){
+			if( kShuffle_ ){
+				for( size_t n = 0; n < fold; n++ ){
+					size_t L = seqs_[i]->getL();
+					uint8_t* sequence = ( uint8_t* )calloc( L, sizeof( uint8_t ) );
+					size_t* kmer = ( size_t* )calloc( L, sizeof( size_t ) );
+					Xoshiro256 rng( seed_, i * fold + n );
+					shuffle_letters( seqs_[i], sequence, kmer, rng );
+					negset[i * fold + n] = util::make_unique<Sequence>( sequence, kmer, L, "> bg_seq", Y_ );
+				}
+				continue;
+			}
+			if( !genericNeg_ ){
+				rescale_kmer_frequency( seqs_[i], n_seq, v_seq, range_bar );
+				build_alias_tables( range_bar, aliasProb, alias );
+			}
+			for( size_t n = 0; n < fold; n++ ){
+				// each sequence draws from its own random number stream
+				Xoshiro256 rng( seed_, i * fold + n );
+				negset[i * fold + n] = bg_sequence( seqs_[i]->getL(),
+													genericNeg_ ? aliasProb_ : aliasProb,
+													genericNeg_ ? alias_ : alias,
+													rng );
+			}
 		}
+
+		free_rescaled_tables( n_seq, v_seq, range_bar, aliasProb, alias );
 	}
 
 	return negset;
@@ -208,142 +359,373 @@ std::vector<std::unique_ptr<Sequence>> SeqGenerator::sample_bgseqset_by_fold(siz
 // generate negative sequences based on k-mer frequencies, given negative sequence number and max length of input seqs
 std::vector<std::unique_ptr<Sequence>> SeqGenerator::sample_bgseqset_by_num(size_t negN, size_t maxL){
 
-    std::vector<std::unique_ptr<Sequence>> negset;
+    std::vector<std::unique_ptr<Sequence>> negset( negN );
 
     calculate_kmer_frequency();
 
-    // todo: can be parallised
+#pragma omp parallel for schedule( dynamic, 16 )
     for( size_t n = 0; n < negN; n++ ){
-        negset.push_back( bg_sequence(maxL) );
+        Xoshiro256 rng( seed_, n );
+        negset[n] = bg_sequence( maxL, aliasProb_, alias_, rng );
     }
 
     return negset;
 }
 
+// shuffle refSeq such that its (sOrder+1)-mer counts are preserved exactly, unknown letters
+// and the separator of the strands stay in place and split the sequence into segments
+void SeqGenerator::shuffle_letters( Sequence* refSeq, uint8_t* sequence, size_t* kmer, Xoshiro256& rng ){
 
-// generate each background sequence based on k-mer frequencies from positive set
-std::unique_ptr<Sequence> SeqGenerator::bg_sequence(size_t L){
+	size_t L = refSeq->getL();
+	uint8_t* ref = refSeq->getSequence();
 
-    assert( kmer_freq_is_calculated_ );
+	size_t start = 0;
+	while( start < L ){
+		if( ref[start] == 0 ){
+			sequence[start] = 0;
+			start++;
+			continue;
+		}
+		size_t end = start;
+		while( end < L and ref[end] != 0 ){
+			end++;
+		}
+		shuffle_segment( ref + start, end - start, sequence + start, rng );
+		start = end;
+	}
 
-    uint8_t* sequence = ( uint8_t* )calloc( L, sizeof( uint8_t ) );
-	std::string header = "> bg_seq";
-
-	// sample the first nucleotide
-	float random = ( float )rand() / ( float )RAND_MAX;
-	for( uint8_t y = 0; y < Y_[1]; y++ ){
-		if( random <= range_bar_[0][y] ){
-			sequence[0] = y+1;
-			break;
+	// k-mers as in the Sequence constructor, with unknown letters randomized
+	size_t y = 0;
+	for( size_t i = 0; i < L; i++ ){
+		size_t a = ( sequence[i] == 0 ) ? ( size_t )( ( ( rng() >> 32 ) * Y_[1] ) >> 32 )
+										: ( size_t )( sequence[i] - 1 );
+		y = ( y % Y_[10] ) * Y_[1] + a;
+		kmer[i] = y;
+	}
+}
+
+// k-let shuffle of a segment without unknown letters (Altschul and Erickson, 1985; Kandel et al., 1996)
+void SeqGenerator::shuffle_segment( uint8_t* seg, size_t m, uint8_t* out, Xoshiro256& rng ){
+
+	/**
+	 * The segment is an Eulerian path through the graph of its d-mers
+	 * (d = sOrder), with one edge per (d+1)-mer. A random Eulerian path
+	 * with the same start and end is drawn uniformly as follows:
+	 * 1. draw a random arborescence of last exits towards the end vertex,
+	 *    by loop-erased random walks (Wilson's algorithm)
+	 * 2. shuffle the other exits of each vertex
+	 * 3. walk from the start vertex, taking the exits in this order
+	 * All steps take linear time in the segment length.
+	 */
+
+	size_t d = sOrder_;
+	size_t A = Y_[1];
+
+	auto uniform = [&rng]( size_t n ){
+		return ( size_t )( ( ( rng() >> 32 ) * n ) >> 32 );
+	};
+
+	std::memcpy( out, seg, m );
+
+	if( d == 0 ){
+		// preserve the letter counts only
+		for( size_t i = m; i > 1; i-- ){
+			std::swap( out[i-1], out[uniform( i )] );
 		}
+		return;
+	}
+	if( m <= d+1 ){
+		// at most one (d+1)-mer, the segment is the only arrangement
+		return;
+	}
+
+	// per-thread workspace over all d-mers, only the visited entries are reset
+	static thread_local std::vector<size_t> cnt, offset, used, next;
+	static thread_local std::vector<uint8_t> inTree;
+	static thread_local std::vector<size_t> touched;
+	static thread_local std::vector<uint8_t> labels;
+	if( cnt.size() < Y_[d] ){
+		cnt.assign( Y_[d], 0 );
+		offset.assign( Y_[d], 0 );
+		used.assign( Y_[d], 0 );
+		next.assign( Y_[d], 0 );
+		inTree.assign( Y_[d], 0 );
 	}
+	touched.clear();
+	labels.resize( m-d );
 
-	// sample the next ( sOrder-1 ) nucleotides
-	for( size_t i = 1; i < sOrder_; i++ ){
+	auto target = [&]( size_t x, size_t a ){
+		return ( x % Y_[d-1] ) * A + a;
+	};
 
-		// extract y from k-mer
-		size_t yk = 0;
-		for( size_t k = i; k > 0; k-- ){
-			yk += ( sequence[i-k] - 1 ) * Y_[k];
+	// d-mers along the segment, the edges leave them with the next letter
+	size_t first = 0;
+	for( size_t t = 0; t < d; t++ ){
+		first = first * A + ( seg[t] - 1 );
+	}
+	size_t x = first;
+	for( size_t p = 0; p < m-d; p++ ){
+		if( cnt[x]++ == 0 ){
+			touched.push_back( x );
 		}
+		x = target( x, seg[p+d] - 1 );
+	}
+	size_t last = x;
 
-		// sample a nucleotide based on k-mer frequency
-		random = ( float )rand() / ( float )RAND_MAX;
-        for( size_t y = yk, a = 1; y < yk+Y_[1]; y++, a++ ){
-            sequence[i] = a;
-            if( random <= range_bar_[i][y] ){
-                break;
-            }
-        }
+	size_t sum = 0;
+	for( size_t v : touched ){
+		offset[v] = sum;
+		sum += cnt[v];
+	}
+	x = first;
+	for( size_t p = 0; p < m-d; p++ ){
+		labels[offset[x] + used[x]++] = ( uint8_t )( seg[p+d] - 1 );
+		x = target( x, seg[p+d] - 1 );
 	}
 
-    // sample the rest residues from sOrder to L
-	for( size_t i = sOrder_; i < L; i++ ){
+	// 1. arborescence of last exits
+	inTree[last] = 1;
+	for( size_t u : touched ){
+		for( x = u; !inTree[x]; ){
+			next[x] = uniform( cnt[x] );
+			x = target( x, labels[offset[x] + next[x]] );
+		}
+		for( x = u; !inTree[x]; ){
+			inTree[x] = 1;
+			x = target( x, labels[offset[x] + next[x]] );
+		}
+	}
 
-		// calculate y of K-mer
-		size_t yk = 0;
-		for( size_t k = sOrder_; k > 0; k-- ){
-			yk += ( sequence[i-k] - 1 ) * Y_[k];
+	// 2. move the last exit to the end and shuffle the others
+	for( size_t v : touched ){
+		uint8_t* l = labels.data() + offset[v];
+		size_t n = cnt[v];
+		if( v != last ){
+			std::swap( l[next[v]], l[n-1] );
+			n--;
 		}
+		for( size_t i = n; i > 1; i-- ){
+			std::swap( l[i-1], l[uniform( i )] );
+		}
+		used[v] = 0;
+	}
 
-        random = ( float )rand() / ( float )RAND_MAX;
-        for( size_t y = yk, a = 1; y < yk+Y_[1]; y++, a++ ){
-            sequence[i] = a;
-            if( random <= range_bar_[sOrder_][y] ){
-			    break;
-            }
-        }
+	// 3. walk along the exits
+	x = first;
+	for( size_t p = 0; p < m-d; p++ ){
+		uint8_t a = labels[offset[x] + used[x]++];
+		out[p+d] = a + 1;
+		x = target( x, a );
+	}
+
+	for( size_t v : touched ){
+		cnt[v] = 0;
+		used[v] = 0;
+		inTree[v] = 0;
+	}
+	inTree[last] = 0;
+}
+
+// generate the n-th sequence of sample_bgseqset_by_fold( fold ) into the given buffers
+void SeqGenerator::sample_bgseq_by_fold( size_t n, size_t fold, uint8_t* sequence, size_t* kmer ){
+
+	assert( kmer_freq_is_calculated_ );
+
+	size_t i = n / fold;
+	Xoshiro256 rng( seed_, n );
+
+	if( kShuffle_ ){
+		shuffle_letters( seqs_[i], sequence, kmer, rng );
+	} else if( genericNeg_ ){
+		sample_letters( seqs_[i]->getL(), sequence, kmer, aliasProb_, alias_, rng );
+	} else if( !refAliasProbs_.empty() ){
+		sample_letters( seqs_[i]->getL(), sequence, kmer, &refAliasProbs_[i * ( sOrder_+1 )],
+						&refAliases_[i * ( sOrder_+1 )], rng );
+	} else {
+		RescaledTables& t = rescaledTables;
+		if( t.owner != id_ ){
+			t.release();
+			calloc_rescaled_tables( t.n_seq, t.v_seq, t.range_bar, t.aliasProb, t.alias );
+			t.owner = id_;
+			t.sOrder = sOrder_;
+			t.ref = seqs_.size();
+		}
+		if( t.ref != i ){
+			rescale_kmer_frequency( seqs_[i], t.n_seq, t.v_seq, t.range_bar );
+			build_alias_tables( t.range_bar, t.aliasProb, t.alias );
+			t.ref = i;
+		}
+		sample_letters( seqs_[i]->getL(), sequence, kmer, t.aliasProb, t.alias, rng );
 	}
+}
 
-    std::unique_ptr<Sequence> bg_seq = util::make_unique<Sequence>( sequence, L, header, Y_, true );
-	if( sequence ) free( sequence );
+void SeqGenerator::cache_rescaled_tables( size_t maxBytes ){
 
-	return bg_seq;
+	assert( kmer_freq_is_calculated_ );
 
+	if( genericNeg_ or kShuffle_ or !refAliasProbs_.empty() ){
+		return;
+	}
+
+	size_t tableSize = 0;
+	for( size_t k = 0; k < sOrder_+1; k++ ){
+		tableSize += Y_[k+1];
+	}
+	if( seqs_.size() * tableSize * ( sizeof( float ) + sizeof( uint8_t ) ) > maxBytes ){
+		return;
+	}
+
+	refAliasProb_.resize( seqs_.size() * tableSize );
+	refAlias_.resize( seqs_.size() * tableSize );
+	refAliasProbs_.resize( seqs_.size() * ( sOrder_+1 ) );
+	refAliases_.resize( seqs_.size() * ( sOrder_+1 ) );
+	for( size_t i = 0; i < seqs_.size(); i++ ){
+		size_t offset = i * tableSize;
+		for( size_t k = 0; k < sOrder_+1; k++ ){
+			refAliasProbs_[i * ( sOrder_+1 ) + k] = &refAliasProb_[offset];
+			refAliases_[i * ( sOrder_+1 ) + k] = &refAlias_[offset];
+			offset += Y_[k+1];
+		}
+	}
+
+#pragma omp parallel
+	{
+		size_t** n_seq;
+		float** v_seq;
+		float** range_bar;
+		float** aliasProb;
+		uint8_t** alias;
+		calloc_rescaled_tables( n_seq, v_seq, range_bar, aliasProb, alias );
+
+#pragma omp for schedule( dynamic, 16 )
+		for( size_t i = 0; i < seqs_.size(); i++ ){
+			rescale_kmer_frequency( seqs_[i], n_seq, v_seq, range_bar );
+			build_alias_tables( range_bar, &refAliasProbs_[i * ( sOrder_+1 )], &refAliases_[i * ( sOrder_+1 )] );
+		}
+
+		free_rescaled_tables( n_seq, v_seq, range_bar, aliasProb, alias );
+	}
 }
 
-std::unique_ptr<Sequence> SeqGenerator::bgseq_on_rescaled_v( Sequence* refSeq ) {
+// generate the n-th sequence of sample_bgseqset_by_num( negN, L ) into the given buffers
+void SeqGenerator::sample_bgseq_by_num( size_t n, size_t L, uint8_t* sequence, size_t* kmer ){
 
-    assert( kmer_freq_is_calculated_ );
+	assert( kmer_freq_is_calculated_ );
 
-    rescale_kmer_frequency( refSeq );
+	Xoshiro256 rng( seed_, n );
+	sample_letters( L, sequence, kmer, aliasProb_, alias_, rng );
+}
 
-    assert( kmer_freq_is_rescaled_ );
+size_t SeqGenerator::getRefL( size_t i ){
+	return seqs_[i]->getL();
+}
 
-    size_t L = refSeq->getL();
-    uint8_t* sequence = ( uint8_t* )calloc( L, sizeof( uint8_t ) );
-    std::string header = "> bg_seq";
-
-    // sample the first nucleotide
-    float random = ( float )rand() / ( float )RAND_MAX;
-    for( uint8_t y = 0; y < Y_[1]; y++ ){
-        if( random <= range_bar_[0][y] ){
-            sequence[0] = y+1;
-            break;
-        }
-    }
+size_t SeqGenerator::getRefN(){
+	return seqs_.size();
+}
 
-    // sample the next ( sOrder-1 ) nucleotides
-    for( size_t i = 1; i < sOrder_; i++ ){
+void SeqGenerator::calloc_rescaled_tables( size_t**& n_seq, float**& v_seq, float**& range_bar,
+										   float**& aliasProb, uint8_t**& alias ){
 
-        // extract y from k-mer
-        size_t yk = 0;
-        for( size_t k = i; k > 0; k-- ){
-            yk += ( sequence[i-k] - 1 ) * Y_[k];
-        }
+	n_seq = ( size_t** )calloc( sOrder_+1, sizeof( size_t* ) );
+	v_seq = ( float** )calloc( sOrder_+1, sizeof( float* ) );
+	range_bar = ( float** )calloc( sOrder_+1, sizeof( float* ) );
+	aliasProb = ( float** )calloc( sOrder_+1, sizeof( float* ) );
+	alias = ( uint8_t** )calloc( sOrder_+1, sizeof( uint8_t* ) );
+	for( size_t k = 0; k < sOrder_+1; k++ ){
+		n_seq[k] = ( size_t* )calloc( Y_[k+1], sizeof( size_t ) );
+		v_seq[k] = ( float* )calloc( Y_[k+1], sizeof( float ) );
+		range_bar[k] = ( float* )calloc( Y_[k+1], sizeof( float ) );
+		aliasProb[k] = ( float* )calloc( Y_[k+1], sizeof( float ) );
+		alias[k] = ( uint8_t* )calloc( Y_[k+1], sizeof( uint8_t ) );
+	}
+}
 
-        // sample a nucleotide based on k-mer frequency
-        random = ( float )rand() / ( float )RAND_MAX;
-        for( size_t y = yk, a = 1; y < yk+Y_[1]; y++, a++ ){
-            sequence[i] = a;
-            if( random <= range_bar_[i][y] ){
-                break;
-            }
-        }
-    }
+void SeqGenerator::free_rescaled_tables( size_t** n_seq, float** v_seq, float** range_bar,
+										 float** aliasProb, uint8_t** alias ){
 
-    // sample the rest residues from sOrder to L
-    for( size_t i = sOrder_; i < L; i++ ){
+	for( size_t k = 0; k < sOrder_+1; k++ ){
+		free( n_seq[k] );
+		free( v_seq[k] );
+		free( range_bar[k] );
+		free( aliasProb[k] );
+		free( alias[k] );
+	}
+	free( n_seq );
+	free( v_seq );
+	free( range_bar );
+	free( aliasProb );
+	free( alias );
+}
 
-        // calculate y of K-mer
-        size_t yk = 0;
-        for( size_t k = sOrder_; k > 0; k-- ){
-            yk += ( sequence[i-k] - 1 ) * Y_[k];
-        }
+// generate L letters and their k-mers directly into the given buffers
+void SeqGenerator::sample_letters( size_t L, uint8_t* sequence, size_t* kmer,
+								   float** aliasProb, uint8_t** alias, Xoshiro256& rng ){
 
-        random = ( float )rand() / ( float )RAND_MAX;
-        for( size_t y = yk, a = 1; y < yk+Y_[1]; y++, a++ ){
-            sequence[i] = a;
-            if( random <= range_bar_[sOrder_][y] ){
-                break;
-            }
-        }
-    }
+	const size_t A = Y_[1];
+	const float scale = 1.0f / ( float )( 1 << 24 );
 
-    std::unique_ptr<Sequence> bg_seq = util::make_unique<Sequence>( sequence, L, header, Y_, true );
-    if( sequence ) free( sequence );
+	/**
+	 * ctx holds the last sOrder letters and y the last 11 letters, as in the
+	 * k-mer arrays of sequences. Both are updated by removing the letter
+	 * that drops out instead of taking a modulo, which keeps divisions out
+	 * of the loop.
+	 */
+	size_t ctx = 0;
+	size_t y = 0;
+	size_t i = 0;
+
+	// the first sOrder positions are drawn from the lower-order models
+	for( ; i < std::min( sOrder_, L ); i++ ){
+		uint64_t r = rng();
+		// one random number picks the coin (upper 24 bits) and the column (the 32
+		// bits below), the lowest bits of xoshiro256+ are weak and left out
+		size_t col = ( size_t )( ( ( ( r >> 8 ) & 0xFFFFFFFF ) * A ) >> 32 );
+		float coin = ( float )( r >> 40 ) * scale;
+		size_t yk = ctx * A + col;
+		size_t a = ( coin < aliasProb[i][yk] ) ? col : alias[i][yk];
+
+		sequence[i] = ( uint8_t )( a + 1 );
+		ctx = ctx * A + a;
+		y = y * A + a;
+		kmer[i] = y;
+	}
+
+	const float* prob = aliasProb[sOrder_];
+	const uint8_t* aliasK = alias[sOrder_];
+	const size_t YctxLead = sOrder_ > 0 ? Y_[sOrder_-1] : 0;
+
+	for( ; i < L; i++ ){
+		uint64_t r = rng();
+		size_t col = ( size_t )( ( ( ( r >> 8 ) & 0xFFFFFFFF ) * A ) >> 32 );
+		float coin = ( float )( r >> 40 ) * scale;
+		size_t yk = ctx * A + col;
+		size_t a = ( coin < prob[yk] ) ? col : aliasK[yk];
+
+		sequence[i] = ( uint8_t )( a + 1 );
+		if( sOrder_ > 0 ){
+			ctx = ( ctx - ( size_t )( sequence[i-sOrder_] - 1 ) * YctxLead ) * A + a;
+		}
+		if( i >= 11 ){
+			y -= ( size_t )( sequence[i-11] - 1 ) * Y_[10];
+		}
+		y = y * A + a;
+		kmer[i] = y;
+	}
+}
+
+// generate each background sequence from the alias tables of the k-mer model
+std::unique_ptr<Sequence> SeqGenerator::bg_sequence( size_t L, float** aliasProb, uint8_t** alias, Xoshiro256& rng ){
+
+    assert( kmer_freq_is_calculated_ );
+
+    // the sequence takes over both buffers
+    uint8_t* sequence = ( uint8_t* )calloc( L, sizeof( uint8_t ) );
+    size_t* kmer = ( size_t* )calloc( L, sizeof( size_t ) );
+
+    sample_letters( L, sequence, kmer, aliasProb, alias, rng );
 
-    return bg_seq;
+	return util::make_unique<Sequence>( sequence, kmer, L, "> bg_seq", Y_ );
 
 }
 
@@ -10,7 +10,8 @@ class SeqGenerator {
 
 	/*
 	 * This class generates artificial sequences sets as listed:
-	 * 1. negative sequence set, by using s-mer frequencies;
+	 * 1. negative sequence set, by using s-mer frequencies, or by shuffling the
+	 *    input sequences with their s-mer counts preserved;
 	 * 2. simulated positive sequence set, by inserting motif into the negative sequence set;
 	 * 3. negative sequence set with motif patterns masked from the positive sequences.
 	 * Prerequisite:
@@ -20,12 +21,25 @@ class SeqGenerator {
 	 */
 
 public:
-	SeqGenerator( std::vector<Sequence*> seqs, Motif* motif = NULL, size_t sOrder = 2, float q = 1.f, bool genericNeg = false );
+	SeqGenerator( std::vector<Sequence*> seqs, Motif* motif = NULL, size_t sOrder = 2, float q = 1.f,
+				  bool genericNeg = false, bool kShuffle = false );
 
 	~SeqGenerator();
 
 	std::vector<std::unique_ptr<Sequence>> sample_bgseqset_by_fold(size_t fold);
     std::vector<std::unique_ptr<Sequence>> sample_bgseqset_by_num(size_t negN, size_t maxL);
+	// generate single sequences of the sets above on demand, e.g. for BgSeqSource,
+	// after calculate_kmer_frequency(); the buffers hold as many entries as the sequence
+	void sample_bgseq_by_fold( size_t n, size_t fold, uint8_t* sequence, size_t* kmer );
+	void sample_bgseq_by_num( size_t n, size_t L, uint8_t* sequence, size_t* kmer );
+	void calculate_kmer_frequency();
+	// keep the alias tables rescaled to each input sequence, if they take at most
+	// maxBytes, such that sample_bgseq_by_fold() does not rescale them again
+	void cache_rescaled_tables( size_t maxBytes );
+
+	size_t getRefN();					// number of input sequences
+	size_t getRefL( size_t i );			// length of input sequence i
+
 	std::vector<std::unique_ptr<Sequence>> arti_posset_motif_embedded(size_t at);
 	std::vector<std::unique_ptr<Sequence>> seqset_with_motif_masked(float **r);
 
@@ -35,11 +49,29 @@ public:
 
 private:
 
-	void						calculate_kmer_frequency();
-    void                        rescale_kmer_frequency( Sequence* refSeq );
-
-	std::unique_ptr<Sequence> 	bg_sequence( size_t L );
-    std::unique_ptr<Sequence>   bgseq_on_rescaled_v( Sequence* refSeq );
+    // rescale the k-mer frequencies to the reference sequence, writes into the given tables
+    void                        rescale_kmer_frequency( Sequence* refSeq, size_t** n_seq,
+                                                        float** v_seq, float** range_bar );
+
+    // count k-mers of all orders: the highest order is counted, lower orders are summed up from it
+    void                        count_kmers( Sequence* seq, size_t** n );
+    void                        marginalize_kmer_counts( size_t** n );
+
+    // shuffle the reference sequence with its (sOrder+1)-mer counts preserved
+    void                        shuffle_letters( Sequence* refSeq, uint8_t* sequence, size_t* kmer, Xoshiro256& rng );
+    void                        shuffle_segment( uint8_t* seg, size_t m, uint8_t* out, Xoshiro256& rng );
+
+    void                        calloc_rescaled_tables( size_t**& n_seq, float**& v_seq, float**& range_bar,
+                                                        float**& aliasProb, uint8_t**& alias );
+    void                        free_rescaled_tables( size_t** n_seq, float** v_seq, float** range_bar,
+                                                      float** aliasProb, uint8_t** alias );
+    // build Walker's alias tables for each context from the cumulated k-mer frequencies
+    void                        build_alias_tables( float** range_bar, float** aliasProb, uint8_t** alias );
+    // sample L letters and their k-mer values into the given buffers
+    void                        sample_letters( size_t L, uint8_t* sequence, size_t* kmer,
+                                                float** aliasProb, uint8_t** alias, Xoshiro256& rng );
+
+	std::unique_ptr<Sequence> 	bg_sequence( size_t L, float** aliasProb, uint8_t** alias, Xoshiro256& rng );
     std::unique_ptr<Sequence> 	raw_sequence( Sequence* refSeq );
 	std::unique_ptr<Sequence> 	posseq_motif_embedded( Sequence* seq, size_t at );
 	std::unique_ptr<Sequence>	sequence_with_motif_masked( Sequence* posseq, size_t W, float *r );
@@ -49,22 +81,27 @@ private:
     float**                     v_;             // k-mer conditional probabilities
 	size_t** 					n_;			    // k-mer counts
     float**                     range_bar_;     // store cumulated sum of k-mers
-
-    // for re-scaling the background model
-    float**                     v_seq_;         // sequence-specific k-mer conditional probabilities
-    size_t** 					n_seq_;			// sequence-specific k-mer counts
+    float**                     aliasProb_;     // alias tables of the k-mer model: probability to keep a column
+    uint8_t**                   alias_;         // alias tables of the k-mer model: the alias of a column
 
     float*                      A_;             // pseudo-parameter for k-mer counting
 	Motif* 						motif_;			// the optimized motif
 	size_t						sOrder_;	    // the order of k-mers for generating negative/pseudo sequence set
     float                       q_;             // portion of sequences in the set that are masked/embedded with the motif
     bool                        genericNeg_;   // flag for generating sequence specific negative sequences
+    bool                        kShuffle_;      // flag for shuffling the input sequences instead of sampling from the k-mer model
 
     std::mt19937                rngx_;
+    size_t                      id_;            // distinguishes generators in the per-thread tables
+    size_t                      seed_;          // seed of the random number streams for generated sequences
     std::vector<size_t>			Y_;
     size_t                      N_;             // input sequence number
+
+    std::vector<float>          refAliasProb_;  // cached alias tables of each input sequence, all orders
+    std::vector<uint8_t>        refAlias_;
+    std::vector<float*>         refAliasProbs_; // sOrder+1 pointers into the cached tables per input sequence
+    std::vector<uint8_t*>       refAliases_;
     bool                        kmer_freq_is_calculated_;
-    bool                        kmer_freq_is_rescaled_;
 
 };
 
@@ -23,7 +23,7 @@ int main( int nargs, char* args[] ){
         /**
          * Sample background sequence set based on s-mer frequencies from the input sequence set
          */
-        SeqGenerator negseq( GSimu::sequenceSet->getSequences(), NULL, GSimu::sOrder );
+        SeqGenerator negseq( GSimu::sequenceSet->getSequences(), NULL, GSimu::sOrder, 1.f, false, GSimu::kShuffle );
         negseq.write( GSimu::outputDirectory,
                       GSimu::sequenceBasename + "_bgset",
                       negseq.sample_bgseqset_by_fold(GSimu::mFold) );
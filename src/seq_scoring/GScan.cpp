@@ -15,6 +15,7 @@ std::string         GScan::posSequenceBasename;			// basename of positive sequen
 SequenceSet*        GScan::posSequenceSet = NULL;		// positive sequence set
 float               GScan::q = 0.3f;					// prior probability for a positive sequence to contain a motif
 bool                GScan::ss = false;					// only search on single strand sequences
+bool                GScan::revCompTable = false;		// score the reverse strands by a reverse-complemented score table
 
 char*               GScan::negSequenceFilename = NULL;	// filename of negative sequence FASTA file
 SequenceSet*        GScan::negSequenceSet = NULL;		// negative sequence set
@@ -40,10 +41,18 @@ bool                GScan::interpolateBG = true;		// calculate prior probabiliti
                                                         // instead of background frequencies of mononucleotides
 // background model options
 char*				GScan::bgModelFilename = NULL;		// path to the background model file
+char*				GScan::bgModelStore = NULL;			// directory of the background k-mer count store
 size_t			    GScan::bgModelOrder = 2;			// background model order, defaults to 2
 std::vector<float>  GScan::bgModelAlpha( bgModelOrder+1, 1.f );// background model alpha
 
 float               GScan::pvalCutoff = 0.0001f;        // cutoff of p-value
+bool                GScan::thresholdScan = false;       // only score positions which can reach the p-value cutoff
+size_t              GScan::quantize = 0;                // bits of quantized score tables, 0 for float scores
+char*               GScan::seedIndex = NULL;            // directory of the q-mer index for seeding the threshold scan
+size_t              GScan::seedLength = 10;             // q, the length of the indexed q-mers
+std::string         GScan::outputFormat = "occurrence"; // format of the occurrence file: occurrence, bed or binary
+char*               GScan::serve = NULL;                // socket path of the resident scanner, see ScanServer
+size_t              GScan::maxRequestMB = 256;          // size limit of the requests to the resident scanner
 
 // for openMP
 size_t              GScan::threads = 4;
@@ -54,9 +63,10 @@ void GScan::init( int nargs, char* args[] ){
 
     Alphabet::init( alphabetType );
 
-    // read in positive, negative and background sequence set
-    posSequenceSet = new SequenceSet( posSequenceFilename, ss );
-    negSequenceSet = new SequenceSet( negSequenceFilename, ss );
+    // read in positive, negative and background sequence set; the reverse
+    // complements are not stored when they are scored by the score table
+    posSequenceSet = new SequenceSet( posSequenceFilename, ss or revCompTable );
+    negSequenceSet = new SequenceSet( negSequenceFilename, ss or revCompTable );
 }
 
 int GScan::readArguments( int nargs, char* args[] ){
@@ -108,6 +118,8 @@ int GScan::readArguments( int nargs, char* args[] ){
             mFold = std::stoi( args[i] );
         } else if( !strcmp( args[i], "--ss" ) ){
             ss = true;
+        } else if( !strcmp( args[i], "--revCompTable" ) ){
+            revCompTable = true;
         } else if( !strcmp( args[i], "--negSeqFile" ) ){
             if( ++i >= nargs ){
                 printHelp();
@@ -153,6 +165,13 @@ int GScan::readArguments( int nargs, char* args[] ){
                 exit( 2 );
             }
             bgModelFilename = args[i];
+        } else if( !strcmp( args[i], "--bgModelStore" ) ){
+            if( ++i >= nargs ){
+                printHelp();
+                std::cerr << "No expression following --bgModelStore" << std::endl;
+                exit( 2 );
+            }
+            bgModelStore = args[i];
         } else if( !strcmp( args[i], "--saveInitialModel" ) ){
             saveInitialModel = true;
         } else if( !strcmp( args[i], "--maxPWM" ) ){
@@ -208,6 +227,64 @@ int GScan::readArguments( int nargs, char* args[] ){
                 exit( 2 );
             }
             pvalCutoff = std::stof( args[i] );
+        } else if( !strcmp( args[i], "--thresholdScan" ) ){
+            thresholdScan = true;
+        } else if( !strcmp( args[i], "--quantize" ) ){
+            if( ++i >= nargs ){
+                printHelp();
+                std::cerr << "No expression following --quantize" << std::endl;
+                exit( 2 );
+            }
+            quantize = std::stoi( args[i] );
+            if( quantize != 8 and quantize != 16 ){
+                std::cerr << "Error: --quantize takes 8 or 16 bits." << std::endl;
+                exit( 2 );
+            }
+        } else if( !strcmp( args[i], "--seedIndex" ) ){
+            if( ++i >= nargs ){
+                printHelp();
+                std::cerr << "No expression following --seedIndex" << std::endl;
+                exit( 2 );
+            }
+            seedIndex = args[i];
+        } else if( !strcmp( args[i], "--seedLength" ) ){
+            if( ++i >= nargs ){
+                printHelp();
+                std::cerr << "No expression following --seedLength" << std::endl;
+                exit( 2 );
+            }
+            seedLength = std::stoi( args[i] );
+        } else if( !strcmp( args[i], "--outputFormat" ) ){
+            if( ++i >= nargs ){
+                printHelp();
+                std::cerr << "No expression following --outputFormat" << std::endl;
+                exit( 2 );
+            }
+            outputFormat = args[i];
+            if( outputFormat != "occurrence" and outputFormat != "bed" and outputFormat != "binary" ){
+                std::cerr << "Error: --outputFormat takes occurrence, bed or binary." << std::endl;
+                exit( 2 );
+            }
+        } else if( !strcmp( args[i], "--serve" ) ){
+            if( ++i >= nargs ){
+                printHelp();
+                std::cerr << "No expression following --serve" << std::endl;
+                exit( 2 );
+            }
+            serve = args[i];
+        } else if( !strcmp( args[i], "--maxRequestMB" ) ){
+            if( ++i >= nargs ){
+                printHelp();
+                std::cerr << "No expression following --maxRequestMB" << std::endl;
+                exit( 2 );
+            }
+            char* end;
+            long megabytes = strtol( args[i], &end, 10 );
+            if( end == args[i] or *end != '\0' or megabytes < 1 ){
+                std::cerr << "Error: --maxRequestMB takes a positive number of megabytes." << std::endl;
+                exit( 2 );
+            }
+            maxRequestMB = ( size_t )megabytes;
         } else if( !strcmp( args[i], "--threads" ) ){
             if( ++i >= nargs ){
                 printHelp();
@@ -234,6 +311,34 @@ int GScan::readArguments( int nargs, char* args[] ){
         exit( 1 );
     }
 
+    // single strands have no reverse strands to score
+    if( ss ){
+        revCompTable = false;
+    }
+
+    if( serve ){
+        if( seedIndex or quantize ){
+            std::cerr << "Error: --serve cannot be combined with --seedIndex or --quantize." << std::endl;
+            exit( 1 );
+        }
+        // the requests are answered by threshold scans
+        thresholdScan = true;
+    }
+
+    if( quantize and ( thresholdScan or seedIndex ) ){
+        std::cerr << "Error: --quantize cannot be combined with --thresholdScan or --seedIndex." << std::endl;
+        exit( 1 );
+    }
+
+    if( seedIndex ){
+        if( revCompTable ){
+            std::cerr << "Error: --seedIndex cannot be combined with --revCompTable." << std::endl;
+            exit( 1 );
+        }
+        // the seeds serve the threshold scan
+        thresholdScan = true;
+    }
+
     modelAlpha.resize( modelOrder+1 );
     if( modelOrder > 0 ){
         for( size_t k = 1; k < modelOrder+1; k++ ){
@@ -269,6 +374,10 @@ void GScan::printHelp(){
               << "\t\t\tThis option is not recommended for analyzing " << std::endl
               << "\t\t\tChIP-seq data. " << std::endl
               << "\t\t\tBy default, BaMM searches motifs on both strands." << std::endl
+              << "\t\t--revCompTable" << std::endl
+              << "\t\t\tStore only the forward strands and score the reverse strands" << std::endl
+              << "\t\t\twith a reverse-complemented copy of the motif score table," << std::endl
+              << "\t\t\twhich halves the memory of the sequences. " << std::endl
               << "\t\t--negSeqFile" << std::endl
               << "\t\t\tFASTA file with negative/background sequences used to " << std::endl
               << "\t\t\tlearn the (homogeneous) background BaMM. " << std::endl
@@ -280,13 +389,17 @@ void GScan::printHelp(){
               << "\t\t\tFile that contains position weight matrices(PWMs)." << std::endl
               << "\t\t\tSame format as MEME" << std::endl
               << "\t\t--BaMMFile <STRING>" << std::endl
-              << "\t\t\tFile that contains a model in bamm file format." << std::endl
+              << "\t\t\tFile that contains a model in bamm file format, or one or more" << std::endl
+              << "\t\t\tmodels in binary bamm file format (.ihbb)." << std::endl
               << "\t\t-k, --order <INTEGER>" << std::endl
               << "\t\t\tmotif model order." << std::endl
               << "\t\t-K, --Order <INTEGER>" << std::endl
               << "\t\t\tbackground model order." << std::endl
               << "\t\t--bgModelFile <STRING>" << std::endl
               << "\t\t\tFile that contains a background model in bamm file format." << std::endl
+              << "\t\t--bgModelStore <STRING>" << std::endl
+              << "\t\t\tdirectory of stored background k-mer counts, which are reused" << std::endl
+              << "\t\t\tfor the same sequence set and the same or a lower order." << std::endl
               << "\t\t--saveInitialModel" << std::endl
               << "\t\t\tsave initial foreground and background models in bamm-format." << std::endl
               << "\t\t--maxPWM <INTEGER>" << std::endl
@@ -294,7 +407,39 @@ void GScan::printHelp(){
               << "\t\t--basename <STRING>" << std::endl
               << "\t\t\tbasename of the outputt files." << std::endl
               << "\t\t--pvalCutoff <FLOAT>" << std::endl
-              << "\t\t\tp-value cutoff for scoring the sequences." << std::endl ;
+              << "\t\t\tp-value cutoff for scoring the sequences." << std::endl
+              << "\t\t--thresholdScan" << std::endl
+              << "\t\t\tonly score the positions which can reach the score of the" << std::endl
+              << "\t\t\tp-value cutoff, and abandon the others early." << std::endl
+              << "\t\t--quantize <INTEGER>" << std::endl
+              << "\t\t\tscore with 16 or 8 bit integer score tables, which are smaller" << std::endl
+              << "\t\t\tand faster; the scores close to the p-value cutoff are" << std::endl
+              << "\t\t\trecomputed, such that the reported p-values do not change." << std::endl
+              << "\t\t--seedIndex <STRING>" << std::endl
+              << "\t\t\tdirectory of a q-mer index of the sequences, which is built" << std::endl
+              << "\t\t\tonce and reused. The threshold scan only scores the windows" << std::endl
+              << "\t\t\taround q-mers that can reach the p-value cutoff, which pays" << std::endl
+              << "\t\t\toff for long sequences and stringent cutoffs." << std::endl
+              << "\t\t--seedLength <INTEGER>" << std::endl
+              << "\t\t\tlength q of the indexed q-mers, at most 11. Defaults to 10." << std::endl
+              << "\t\t--outputFormat <STRING>" << std::endl
+              << "\t\t\tformat of the motif occurrences: occurrence (text, default)," << std::endl
+              << "\t\t\tbed (BED6 on the forward strand with -10*log10(p-value) as" << std::endl
+              << "\t\t\tscore, plus p-value and e-value; in genomic coordinates for" << std::endl
+              << "\t\t\theaders chr:start-end as written by bedtools getfasta), or" << std::endl
+              << "\t\t\tbinary (.occurrence.bin, a columnar table of sequence, start," << std::endl
+              << "\t\t\tscore, p-value, e-value and strand, see py/utils.py)." << std::endl
+              << "\t\t--serve <STRING>" << std::endl
+              << "\t\t\tkeep the motifs, the background model and the scores of the" << std::endl
+              << "\t\t\tnegative sequences sampled from SEQFILE, and answer scan" << std::endl
+              << "\t\t\trequests on this Unix domain socket, see py/bammscan_client.py." << std::endl
+              << "\t\t\tThe --threads answer requests in parallel. A request with" << std::endl
+              << "\t\t\t#shutdown stops the server: any client that can connect to" << std::endl
+              << "\t\t\tthe socket can stop it, so restrict the socket's directory" << std::endl
+              << "\t\t\tto trusted users." << std::endl
+              << "\t\t--maxRequestMB <INTEGER>" << std::endl
+              << "\t\t\tlargest request of --serve in megabytes, larger requests are" << std::endl
+              << "\t\t\trejected. Defaults to 256." << std::endl ;
 }
 
 void GScan::destruct(){
@@ -23,6 +23,7 @@ public:
     static SequenceSet*	posSequenceSet;			// positive sequence set
     static float		q;						// prior probability for a positive sequence to contain a motif
     static bool			ss;						// only search on single strand sequences
+    static bool			revCompTable;			// score the reverse strands by a reverse-complemented score table
     static char*		negSequenceFilename;	// filename of negative sequence FASTA file
     static SequenceSet*	negSequenceSet;			// negative sequence set
     static size_t       mFold;                  // number of negative sequences as multiple of positive sequences
@@ -46,10 +47,18 @@ public:
 
     // background model options
     static char*		bgModelFilename;	    // path to the background model file
+    static char*		bgModelStore;			// directory of the background k-mer count store
     static size_t		bgModelOrder;			// background model order, defaults to 2
     static std::vector<float> bgModelAlpha;		// background model alpha
 
     static float        pvalCutoff;             // cutoff of p-values for scanning motifs
+    static bool         thresholdScan;          // only score positions which can reach the p-value cutoff
+    static size_t       quantize;               // bits of quantized score tables, 0 for float scores
+    static char*        seedIndex;              // directory of the q-mer index for seeding the threshold scan
+    static size_t       seedLength;             // q, the length of the indexed q-mers
+    static std::string  outputFormat;           // format of the occurrence file: occurrence, bed or binary
+    static char*        serve;                  // socket path of the resident scanner, see ScanServer
+    static size_t       maxRequestMB;           // size limit of the requests to the resident scanner
 
     // openMP option
     static size_t       threads;
@@ -0,0 +1,275 @@
+#ifdef OPENMP
+#include <omp.h>
+#endif
+
+#include "ScanServer.h"
+
+#include <cmath>		// e.g. std::isfinite
+#include <sstream>		// e.g. std::istringstream
+#include <thread>
+
+#include <errno.h>		// e.g. EINTR
+#include <signal.h>		// e.g. SIGPIPE
+#include <sys/socket.h>
+#include <sys/un.h>		// e.g. sockaddr_un
+#include <unistd.h>		// e.g. read
+
+ScanServer::ScanServer( std::vector<Motif*> motifs, std::vector<std::string> names, BackgroundModel* bg,
+						std::vector<std::vector<float>> nullScores, bool ss, bool revComp, float pvalCutoff,
+						size_t maxRequestBytes ){
+
+	motifs_ = motifs;
+	names_ = names;
+	bg_ = bg;
+	nullScores_.swap( nullScores );
+	ss_ = ss;
+	revComp_ = revComp;
+	pvalCutoff_ = pvalCutoff;
+	maxRequestBytes_ = maxRequestBytes;
+
+	for( size_t i = 0; i <= 11; i++ ){
+		Y_.push_back( ipow( Alphabet::getSize(), i ) );
+	}
+
+	listenFd_ = -1;
+	stop_ = false;
+}
+
+ScanServer::~ScanServer(){
+	if( listenFd_ >= 0 ){
+		close( listenFd_ );
+	}
+}
+
+void ScanServer::serve( std::string socketPath, size_t workers ){
+
+	// a client which closes its connection early must not end the server
+	signal( SIGPIPE, SIG_IGN );
+
+	sockaddr_un address;
+	memset( &address, 0, sizeof( address ) );
+	address.sun_family = AF_UNIX;
+	if( socketPath.size() >= sizeof( address.sun_path ) ){
+		std::cerr << "Error: Socket path is too long: " << socketPath << std::endl;
+		exit( 1 );
+	}
+	strcpy( address.sun_path, socketPath.c_str() );
+
+	listenFd_ = socket( AF_UNIX, SOCK_STREAM, 0 );
+	unlink( socketPath.c_str() );
+	if( listenFd_ < 0 or bind( listenFd_, ( sockaddr* )&address, sizeof( address ) ) != 0
+		or listen( listenFd_, 64 ) != 0 ){
+		std::cerr << "Error: Cannot listen on socket: " << socketPath << std::endl;
+		exit( 1 );
+	}
+
+	std::vector<std::thread> pool;
+	for( size_t w = 0; w < std::max( workers, size_t( 1 ) ); w++ ){
+		pool.push_back( std::thread( &ScanServer::work, this ) );
+	}
+
+	std::cout << "Listening on " << socketPath << std::endl;
+
+	while( true ){
+		int fd = accept( listenFd_, NULL, NULL );
+		if( fd < 0 ){
+			std::unique_lock<std::mutex> lock( mutex_ );
+			if( stop_ ){
+				break;
+			} else if( errno == EINTR or errno == ECONNABORTED ){
+				continue;
+			}
+			std::cerr << "Error: Cannot accept connections on socket: " << socketPath << std::endl;
+			stop_ = true;
+			break;
+		}
+		std::unique_lock<std::mutex> lock( mutex_ );
+		connections_.push_back( fd );
+		cond_.notify_one();
+	}
+
+	// the workers answer the queued requests before they end
+	cond_.notify_all();
+	for( size_t w = 0; w < pool.size(); w++ ){
+		pool[w].join();
+	}
+
+	close( listenFd_ );
+	listenFd_ = -1;
+	unlink( socketPath.c_str() );
+}
+
+void ScanServer::work(){
+
+#ifdef OPENMP
+	// the requests are scanned in parallel, each by a single thread
+	omp_set_num_threads( 1 );
+#endif
+
+	while( true ){
+		int fd;
+		{
+			std::unique_lock<std::mutex> lock( mutex_ );
+			cond_.wait( lock, [this]{ return stop_ or !connections_.empty(); } );
+			if( connections_.empty() ){
+				return;
+			}
+			fd = connections_.front();
+			connections_.pop_front();
+		}
+		handle( fd );
+	}
+}
+
+void ScanServer::handle( int fd ){
+
+	// an oversized request is read to its end, so that the client gets the error
+	std::string request;
+	bool oversized = false;
+	char buffer[1 << 16];
+	while( true ){
+		ssize_t bytes = read( fd, buffer, sizeof( buffer ) );
+		if( bytes > 0 ){
+			if( !oversized and request.size() + bytes > maxRequestBytes_ ){
+				oversized = true;
+				std::string().swap( request );
+			}
+			if( !oversized ){
+				request.append( buffer, bytes );
+			}
+		} else if( bytes < 0 and errno == EINTR ){
+			continue;
+		} else {
+			break;
+		}
+	}
+
+	FILE* file = fdopen( fd, "wb" );
+	if( file == NULL ){
+		close( fd );
+		return;
+	}
+
+	RecordWriter reply( file );
+	std::string error = oversized ? "The request exceeds " + std::to_string( maxRequestBytes_ ) + " bytes."
+								  : scan( request, reply );
+	if( !error.empty() ){
+		reply.put( "Error: " ).put( error ).put( '\n' );
+	}
+	// a client that has gone is not an error of the server
+	reply.close();
+}
+
+std::string ScanServer::scan( std::string& request, RecordWriter& reply ){
+
+	float pvalCutoff = pvalCutoff_;
+	std::string format = "occurrence";
+
+	/**
+	 * read the options and the FASTA sequences as SequenceSet does, but report
+	 * errors to the client instead of exiting
+	 */
+	std::vector<Sequence*> seqs;
+	Xoshiro256 rng( 42 );
+	auto clear = [&seqs](){
+		for( size_t n = 0; n < seqs.size(); n++ ){
+			delete seqs[n];
+		}
+	};
+	auto store = [&]( std::string& header, std::string& sequence ){
+		if( !sequence.empty() ){
+			size_t L = sequence.length();
+			uint8_t* encoding = ( uint8_t* )calloc( L, sizeof( uint8_t ) );
+			for( size_t i = 0; i < L; i++ ){
+				encoding[i] = Alphabet::getCode( sequence[i] );
+			}
+			seqs.push_back( new Sequence( encoding, L, header, Y_, ss_ or revComp_, &rng ) );
+			free( encoding );
+		}
+		header.clear();
+		sequence.clear();
+	};
+
+	std::istringstream stream( request );
+	std::string line, header, sequence;
+	while( getline( stream, line ) ){
+
+		if( line.empty() ){
+			continue;
+		}
+
+		if( line[0] == '#' and header.empty() and seqs.empty() ){
+			std::istringstream options( line.substr( 1 ) );
+			std::string option, value;
+			options >> option >> value;
+			if( option == "pvalCutoff" ){
+				char* end = NULL;
+				pvalCutoff = strtof( value.c_str(), &end );
+				if( value.empty() or *end != '\0' or !std::isfinite( pvalCutoff )
+					or pvalCutoff < 0.0f or pvalCutoff > 1.0f ){
+					return "#pvalCutoff takes a number from 0 to 1.";
+				}
+			} else if( option == "format" ){
+				if( value != "occurrence" and value != "bed" ){
+					return "#format takes occurrence or bed.";
+				}
+				format = value;
+			} else if( option == "shutdown" ){
+				std::unique_lock<std::mutex> lock( mutex_ );
+				stop_ = true;
+				// wake up accept() in serve()
+				shutdown( listenFd_, SHUT_RDWR );
+				cond_.notify_all();
+				return "";
+			} else {
+				return "Unknown option #" + option;
+			}
+		} else if( line[0] == '>' ){
+			store( header, sequence );
+			if( line.length() == 1 ){
+				header = '>';
+			} else {
+				// fetch header till the first tab, without the '\r' terminator
+				header = line.substr( 0, line.find_first_of( "\t\r" ) );
+			}
+		} else if( !header.empty() ){
+			if( line.find( ' ' ) != std::string::npos ){
+				clear();
+				return "FASTA sequence contains space character.";
+			}
+			sequence += line;
+		} else {
+			clear();
+			return "Wrong FASTA format.";
+		}
+	}
+	store( header, sequence );
+
+	// filter out sequences shorter than the motifs
+	size_t maxW = 0;
+	for( size_t m = 0; m < motifs_.size(); m++ ){
+		maxW = std::max( maxW, motifs_[m]->getW() );
+	}
+	std::vector<Sequence*> scanSeqs;
+	for( size_t n = 0; n < seqs.size(); n++ ){
+		if( seqs[n]->getL() >= maxW ){
+			scanSeqs.push_back( seqs[n] );
+		}
+	}
+
+	for( size_t m = 0; m < motifs_.size(); m++ ){
+
+		// the score tables are calculated into a copy of the motif, per request
+		Motif motif( *motifs_[m] );
+		ScoreSeqSet scanSet( &motif, bg_, scanSeqs );
+		scanSet.setRevComp( revComp_ );
+		scanSet.calcHits( ScoreSeqSet::calcScoreThresholdSorted( nullScores_[m], pvalCutoff ) );
+		scanSet.calcPvaluesSorted( scanSet.getHitScores(), nullScores_[m] );
+
+		reply.put( "# " ).put( names_[m] ).put( '\n' );
+		scanSet.write( reply, pvalCutoff, ss_, format );
+	}
+
+	clear();
+	return "";
+}
@@ -0,0 +1,68 @@
+#ifndef SCANSERVER_H_
+#define SCANSERVER_H_
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "../init/BackgroundModel.h"
+#include "../init/Motif.h"
+#include "../init/RecordWriter.h"
+#include "ScoreSeqSet.h"
+
+class ScanServer{
+
+	/*
+	 * A resident scanner on a Unix domain socket: the motifs, the background
+	 * model and the null distributions of the motif scores, i.e. the sorted
+	 * scores of the negative sequences, are prepared once and kept for all scans.
+	 * Each connection is one scan request, which holds optional lines
+	 *   #pvalCutoff <FLOAT>
+	 *   #format occurrence|bed
+	 *   #shutdown
+	 * followed by FASTA sequences; the client then closes its sending side. The
+	 * reply holds the occurrences of each motif in the format of BaMMScan's
+	 * occurrence or BED files, each after a line "# <motif name>", or a line
+	 * "Error: ...". The requests are threshold scans, which are run by a pool of
+	 * worker threads, one request per thread. Requests above maxRequestBytes are
+	 * read to their end without being kept and rejected. Unknown letters are
+	 * drawn by a generator seeded anew for each request, so that equal requests
+	 * get equal replies.
+	 */
+
+public:
+
+	ScanServer( std::vector<Motif*> motifs, std::vector<std::string> names, BackgroundModel* bg,
+				std::vector<std::vector<float>> nullScores, bool ss, bool revComp, float pvalCutoff,
+				size_t maxRequestBytes );
+	~ScanServer();
+
+	// answer requests until one asks for #shutdown, which any client of the socket may do
+	void					serve( std::string socketPath, size_t workers );
+
+private:
+
+	void					work();						// worker thread: handle queued connections
+	void					handle( int fd );			// read a request, scan and reply
+	std::string				scan( std::string& request, RecordWriter& reply );	// returns an error, if any
+
+	std::vector<Motif*>		motifs_;
+	std::vector<std::string>	names_;
+	BackgroundModel*		bg_;
+	std::vector<std::vector<float>>	nullScores_;	// negative scores of each motif, ascending
+	bool					ss_;
+	bool					revComp_;			// score the reverse strands by a reverse-complemented table
+	float					pvalCutoff_;		// default of the requests
+	size_t					maxRequestBytes_;
+	std::vector<size_t>		Y_;
+
+	int						listenFd_;
+	std::mutex				mutex_;
+	std::condition_variable	cond_;
+	std::deque<int>			connections_;		// accepted connections for the workers
+	bool					stop_;
+};
+
+#endif /* SCANSERVER_H_ */
@@ -5,22 +5,207 @@
  *      Author: wanwan
  */
 
+#ifdef OPENMP
+#include <omp.h>
+#endif
+
 #include "ScoreSeqSet.h"
 #include <float.h>		// -FLT_MAX
+#include <map>
+#include <type_traits>	// e.g. std::is_same
+
+// the (K+1)-mers y of n k-mer values, for compile-time order K and alphabet size A;
+// the instance with A = 0 takes their number Y at runtime
+template<size_t K, size_t A>
+static void extractKmers( const size_t* kmer, size_t n, size_t* y, size_t Y ){
+	const size_t YK1 = ( A > 0 ) ? cpow( A, K+1 ) : Y;
+	for( size_t i = 0; i < n; i++ ){
+		y[i] = kmer[i] % YK1;
+	}
+}
+
+typedef void ( *ExtractKmers )( const size_t*, size_t, size_t*, size_t );
+static const ExtractKmers extractKmersKernels[] = { extractKmers<0,0>,
+	extractKmers<0,4>, extractKmers<1,4>, extractKmers<2,4>,
+	extractKmers<3,4>, extractKmers<4,4>, extractKmers<5,4> };
+
+// the largest magnitude of quantized scores, such that W of them sum up without overflow
+static float quantizedMax( size_t qBits, size_t W ){
+	return ( qBits == 16 ) ? 32767.0f : ( float )std::min( size_t( 127 ), 32767 / W );
+}
+
+// the k-mers of positions b, ..., L-1 of a sequence, followed by pad k-mers which extend it
+// by the complement of the first letter, i.e. by the context in front of its reverse strand
+static void tailKmers( const size_t* kmer, size_t L, size_t b, size_t pad, std::vector<size_t>& tail ){
+	size_t A = Alphabet::getSize();
+	size_t Y10 = ipow( A, 10 );
+	size_t a = Alphabet::getComplementCode( 1 ) - 1;
+	tail.assign( kmer + b, kmer + L );
+	for( size_t p = L; p < L + pad; p++ ){
+		tail.push_back( ( p > 0 ) ? ( ( ( p > L ) ? tail.back() : kmer[L-1] ) % Y10 ) * A + a : a );
+	}
+}
+
+// the score table of the reverse strand, sRC[j * Y[K+1] + y] = s[rc( y )][W-1-j]: applied to
+// the (K+1)-mers from position i+K on, it scores the reverse complement of the window at i
+static std::vector<float> revCompTable( float** s, size_t K, size_t W, size_t YK1 ){
+	std::vector<float> sRC( W * YK1 );
+	for( size_t y = 0; y < YK1; y++ ){
+		size_t rc = Alphabet::getRevCompKmer( y, K+1 );
+		for( size_t j = 0; j < W; j++ ){
+			sRC[j * YK1 + y] = s[rc][W-1-j];
+		}
+	}
+	return sRC;
+}
+
+/**
+ * the best score reachable from column j on, given the K letters before
+ * column j as context c: R[j][c] = max_a( t[j][c*A+a] + R[j+1][(c*A+a) % Y[K]] ),
+ * such that a partial sum plus R of its context bounds the final score; for
+ * a score table t[j * Y[K+1] + y] of W columns, with absSum the sum of the
+ * largest magnitudes of its columns
+ */
+static std::vector<float> lookahead( const std::vector<float>& t, size_t W, size_t A, size_t YK, float& absSum ){
+	size_t YK1 = YK * A;
+	std::vector<float> R( ( W+1 ) * YK, 0.0f );
+	absSum = 0.0f;
+	for( size_t j = W; j-- > 0; ){
+		float absMax = 0.0f;
+		for( size_t c = 0; c < YK; c++ ){
+			float best = -FLT_MAX;
+			for( size_t a = 0; a < A; a++ ){
+				size_t y = c * A + a;
+				best = std::max( best, t[j * YK1 + y] + R[( j+1 ) * YK + y % YK] );
+				absMax = std::max( absMax, fabsf( t[j * YK1 + y] ) );
+			}
+			R[j * YK + c] = best;
+		}
+		absSum += absMax;
+	}
+	return R;
+}
+
+/**
+ * sum up the log odds scores sg of a group of G motifs at the positions of the
+ * segments of a tile, in tiles of cols columns; the scores of type T are summed
+ * up in type Acc, integer sums are mapped back by the scale and shift of each
+ * motif. The scores go into mops[members[g]] at pos[s] + i, or at pos[s] - i for
+ * the reverse strand, and their maxima into segMax[s * M + members[g]]
+ */
+template<typename T, typename Acc>
+static void scoreGroup( const T* sg, size_t G, size_t W, size_t Yk, size_t cols,
+						const float* scale, const float* shift, const size_t* members,
+						const size_t* y, const size_t* yStart, const size_t* loStart, size_t sT,
+						const size_t* pos, bool reverse, float** mops, float* segMax, size_t M,
+						std::vector<Acc>& acc ){
+
+	acc.resize( loStart[sT] * G );
+
+	if( G == 1 ){
+		// a single motif leaves no motifs to vectorize over, and the table lookups
+		// of the positions would need gathers: sum up each window in a register
+		// instead of the column tiles, the table of one motif stays in cache
+		for( size_t s = 0; s < sT; s++ ){
+			const size_t* ys = y + yStart[s];
+			Acc* lo = acc.data() + loStart[s];
+			size_t I = loStart[s+1] - loStart[s];
+			for( size_t i = 0; i < I; i++ ){
+				Acc sum = 0;
+				for( size_t j = 0; j < W; j++ ){
+					sum += sg[j * Yk + ys[i+j]];
+				}
+				lo[i] = sum;
+			}
+		}
+	}
+
+	// sum up the scores of each column tile over all positions of the tile
+	for( size_t j0 = 0; G > 1 and j0 < W; j0 += cols ){
+		size_t j1 = std::min( W, j0 + cols );
+		for( size_t s = 0; s < sT; s++ ){
+			const size_t* ys = y + yStart[s];
+			Acc* lo = acc.data() + loStart[s] * G;
+			for( size_t i = 0; i < loStart[s+1] - loStart[s]; i++, lo += G ){
+				if( j0 == 0 ){
+					std::fill( lo, lo + G, Acc( 0 ) );
+				}
+				for( size_t j = j0; j < j1; j++ ){
+					const T* row = sg + ( j * Yk + ys[i+j] ) * G;
+#pragma omp simd
+					for( size_t g = 0; g < G; g++ ){
+						lo[g] += row[g];
+					}
+				}
+			}
+		}
+	}
+
+	for( size_t s = 0; s < sT; s++ ){
+		const Acc* lo = acc.data() + loStart[s] * G;
+		float* maxScore = segMax + s * M;
+		for( size_t i = 0; i < loStart[s+1] - loStart[s]; i++, lo += G ){
+			size_t p = reverse ? pos[s] - i : pos[s] + i;
+			for( size_t g = 0; g < G; g++ ){
+				float score = std::is_same<Acc, float>::value ?
+							  ( float )lo[g] : ( float )lo[g] * scale[g] + shift[g];
+				size_t m = members[g];
+				if( mops[m] != NULL ){
+					mops[m][p] = score;
+				}
+				if( score > maxScore[m] ){
+					maxScore[m] = score;
+				}
+			}
+		}
+	}
+}
 
 ScoreSeqSet::ScoreSeqSet( Motif* motif, BackgroundModel* bg, std::vector<Sequence*> seqSet ){
 
 	motif_	= motif;
 	bg_ 	= bg;
 	seqSet_	= seqSet;
+	seqSource_ = NULL;
+	stride_	= 1;
+	N_		= seqSet_.size();
+	Y_ 		= motif->getY();
+    pval_is_calulated_ = false;
+    hits_only_ = false;
+    revComp_ = false;
+    keep_scores_ = false;
+}
+
+ScoreSeqSet::ScoreSeqSet( Motif* motif, BackgroundModel* bg, SeqSource* seqSource, size_t stride ){
+
+	motif_	= motif;
+	bg_ 	= bg;
+	seqSource_ = seqSource;
+	stride_	= stride;
+	N_		= seqSource_->getN() / stride_;
 	Y_ 		= motif->getY();
     pval_is_calulated_ = false;
+    hits_only_ = false;
+    revComp_ = false;
+    keep_scores_ = false;
 }
 
 ScoreSeqSet::~ScoreSeqSet(){
 
 }
 
+void ScoreSeqSet::setRevComp( bool revComp ){
+	revComp_ = revComp;
+}
+
+void ScoreSeqSet::setKeepScores( bool keepScores ){
+	keep_scores_ = keepScores;
+}
+
+size_t ScoreSeqSet::getPositions( size_t n, size_t W ){
+	return revComp_ ? 2 * getLW1( n, W ) : getLW1( n, W );
+}
+
 
 void ScoreSeqSet::calcLogOdds(){
 
@@ -28,6 +213,517 @@ void ScoreSeqSet::calcLogOdds(){
 	 * store the log odds scores at all positions of each sequence
 	 */
 
+	size_t W = motif_->getW();
+
+	// score into a flat buffer, then fill the preallocated outputs
+	std::vector<size_t> offset( N_+1, 0 );
+	for( size_t n = 0; n < N_; n++ ){
+		offset[n+1] = offset[n] + getPositions( n, W );
+	}
+	std::vector<float> mops( offset[N_] );
+
+	mops_scores_.resize( N_ );
+	zoops_scores_.resize( N_ );
+	z_.resize( N_ );
+
+	calcLogOdds( mops.data(), zoops_scores_.data() );
+
+#pragma omp parallel for schedule(dynamic, 64)
+	for( size_t n = 0; n < N_; n++ ){
+
+		// take all the log odds scores for MOPS model
+		mops_scores_[n].assign( mops.begin() + offset[n], mops.begin() + offset[n+1] );
+
+		// the position of the largest log odds score for ZOOPS model
+		size_t z_i = 0;
+		for( size_t i = 0; i < mops_scores_[n].size(); i++ ){
+			if( mops_scores_[n][i] == zoops_scores_[n] ){
+				z_i = i;
+				break;
+			}
+		}
+		z_[n] = z_i;
+	}
+}
+
+void ScoreSeqSet::calcLogOdds( float* mops, float* zoops ){
+
+	calcLogOdds( std::vector<ScoreSeqSet*>( 1, this ),
+				 std::vector<float*>( 1, mops ), std::vector<float*>( 1, zoops ) );
+}
+
+void ScoreSeqSet::calcLogOdds( std::vector<ScoreSeqSet*> sets,
+							   std::vector<float*> mops, std::vector<float*> zoops, size_t qBits ){
+
+	if( sets.empty() ){
+		return;
+	}
+
+	// the sequences are taken from the first set
+	ScoreSeqSet* seqs = sets[0];
+	size_t N = seqs->N_;
+	std::vector<size_t> Y = seqs->Y_;
+	bool revComp = seqs->revComp_;
+	size_t strands = revComp ? 2 : 1;
+
+	/**
+	 * group the motifs by order K and length W; the log odds scores of a group
+	 * are interleaved, s[( j * Y[K+1] + y ) * G + g] for its G motifs, such that
+	 * one (K+1)-mer at position j adds to all of them at once. The groups are
+	 * split such that a column of their score table stays in cache, and the
+	 * columns are scored in tiles of as many columns as fit into the cache.
+	 * With setRevComp(), the W columns of the reverse strand table follow.
+	 *
+	 * Quantized tables hold ( s[y][j] - max_y s[y][j] ) * scale as int16, summed
+	 * up in int32, or as int8, summed up in int16; the scale maps the largest
+	 * column range of a motif onto the integer range such that the sums of W
+	 * columns cannot overflow. The sums are mapped back by 1/scale and the
+	 * sum of the column maxima.
+	 */
+	struct Group{
+		size_t				K;
+		size_t				W;
+		size_t				cols;		// columns per tile
+		std::vector<size_t>	members;
+		std::vector<float>	s;
+		std::vector<int16_t> s16;
+		std::vector<int8_t>	s8;
+		std::vector<float>	scale;		// of the quantized scores of each motif
+		std::vector<float>	shift;
+		const size_t*		offset;		// of the sequences in the mops buffers
+	};
+	std::map<std::pair<size_t, size_t>, std::vector<size_t>> byKW;
+	for( size_t m = 0; m < sets.size(); m++ ){
+		Motif* motif = sets[m]->motif_;
+		size_t K = motif->getK();
+		size_t K_bg = ( sets[m]->bg_->getOrder() < K ) ? sets[m]->bg_->getOrder() : K;
+		// pre-calculate log odds scores given motif and bg model
+		motif->calculateLogS( sets[m]->bg_->getV(), K_bg );
+		byKW[std::make_pair( K, motif->getW() )].push_back( m );
+	}
+
+	if( qBits != 0 and qBits != 8 and qBits != 16 ){
+		std::cerr << "Error: Scores can only be quantized to 8 or 16 bits." << std::endl;
+		exit( 1 );
+	}
+	size_t scoreBytes = ( qBits == 0 ) ? sizeof( float ) : qBits / 8;
+
+	size_t maxTableBytes = 1 << 18;
+	std::vector<Group> groups;
+	for( auto& kw : byKW ){
+		size_t K = kw.first.first;
+		size_t W = kw.first.second;
+		size_t maxG = std::max( size_t( 1 ), maxTableBytes / ( Y[K+1] * scoreBytes ) );
+		for( size_t first = 0; first < kw.second.size(); first += maxG ){
+			Group group;
+			group.K = K;
+			group.W = W;
+			group.members.assign( kw.second.begin() + first,
+								  kw.second.begin() + std::min( first + maxG, kw.second.size() ) );
+			size_t G = group.members.size();
+			size_t YG = Y[K+1] * G;
+			group.cols = std::max( size_t( 1 ), maxTableBytes / ( YG * scoreBytes ) );
+			if( qBits == 0 ){
+				group.s.resize( strands * W * YG );
+			} else if( qBits == 16 ){
+				group.s16.resize( strands * W * YG );
+			} else {
+				group.s8.resize( strands * W * YG );
+			}
+			std::vector<size_t> rc( Y[K+1] );
+			for( size_t y = 0; y < Y[K+1]; y++ ){
+				rc[y] = Alphabet::getRevCompKmer( y, K+1 );
+			}
+			group.scale.resize( G, 1.0f );
+			group.shift.resize( G, 0.0f );
+			float qMax = quantizedMax( qBits, W );
+			for( size_t g = 0; g < G; g++ ){
+				float** s = sets[group.members[g]]->motif_->getS();
+				if( qBits == 0 ){
+					for( size_t j = 0; j < W; j++ ){
+						for( size_t y = 0; y < Y[K+1]; y++ ){
+							group.s[( j * Y[K+1] + y ) * G + g] = s[y][j];
+							if( revComp ){
+								group.s[( ( W + j ) * Y[K+1] + y ) * G + g] = s[rc[y]][W-1-j];
+							}
+						}
+					}
+					continue;
+				}
+				std::vector<float> colMax( W, -FLT_MAX );
+				float range = 0.0f;
+				for( size_t j = 0; j < W; j++ ){
+					float colMin = FLT_MAX;
+					for( size_t y = 0; y < Y[K+1]; y++ ){
+						colMax[j] = std::max( colMax[j], s[y][j] );
+						colMin = std::min( colMin, s[y][j] );
+					}
+					range = std::max( range, colMax[j] - colMin );
+					group.shift[g] += colMax[j];
+				}
+				float scale = ( range > 0.0f ) ? qMax / range : 1.0f;
+				group.scale[g] = 1.0f / scale;
+				// the reverse strand columns are those of the forward strand in reverse
+				for( size_t j = 0; j < strands * W; j++ ){
+					size_t jF = ( j < W ) ? j : 2 * W - 1 - j;
+					for( size_t y = 0; y < Y[K+1]; y++ ){
+						size_t yF = ( j < W ) ? y : rc[y];
+						float q = std::max( -qMax, rintf( ( s[yF][jF] - colMax[jF] ) * scale ) );
+						if( qBits == 16 ){
+							group.s16[( j * Y[K+1] + y ) * G + g] = ( int16_t )q;
+						} else {
+							group.s8[( j * Y[K+1] + y ) * G + g] = ( int8_t )q;
+						}
+					}
+				}
+			}
+			groups.push_back( group );
+		}
+	}
+
+	// offsets of the sequences in the mops buffers for each motif length
+	std::vector<size_t> L( N );
+	size_t totalL = 0;
+	for( size_t n = 0; n < N; n++ ){
+		L[n] = seqs->getL( n );
+		totalL += L[n];
+	}
+	std::map<size_t, std::vector<size_t>> offsets;
+	for( auto& kw : byKW ){
+		size_t W = kw.first.second;
+		std::vector<size_t>& offset = offsets[W];
+		if( offset.empty() ){
+			offset.resize( N+1, 0 );
+			for( size_t n = 0; n < N; n++ ){
+				offset[n+1] = offset[n] + seqs->getPositions( n, W );
+			}
+		}
+	}
+	// looked up here, as the threads below must not insert into the shared map
+	for( size_t gr = 0; gr < groups.size(); gr++ ){
+		groups[gr].offset = offsets[groups[gr].W].data();
+	}
+
+	/**
+	 * split the sequences into tiles of segments with about the same total
+	 * length, such that sets of short and long sequences are balanced over
+	 * the threads and the buffers of a tile stay small; stored sequences are
+	 * split into segments, generated ones are kept whole to generate them once
+	 */
+	// a nested team gets the threads set for it by omp_set_num_threads(), e.g.
+	// those of a motif in BaMMmotif; the tasks of a fold in FDR are taken up by
+	// all threads of its team, see inTaskPool() in utils.h
+	size_t threads = poolThreads();
+	size_t tileL = std::min( size_t( 1 ) << 14, totalL / ( 4 * threads ) + 1 );
+	size_t maxW = 0;
+	size_t pad = 0;				// k-mers after the sequence end, the reverse strand context
+	for( size_t gr = 0; gr < groups.size(); gr++ ){
+		maxW = std::max( maxW, groups[gr].W );
+		if( revComp ){
+			pad = std::max( pad, groups[gr].K );
+		}
+	}
+	struct Segment{
+		size_t				n;			// sequence
+		size_t				p0;			// first position
+		size_t				p1;			// end of the positions
+	};
+	std::vector<Segment> segments;
+	std::vector<size_t> tiles( 1, 0 );		// first segment of each tile
+	for( size_t n = 0, sumL = 0; n < N; n++ ){
+		size_t segL = ( seqs->seqSource_ == NULL ) ? tileL : L[n];
+		for( size_t p0 = 0; p0 < L[n]; p0 += segL ){
+			Segment segment = { n, p0, std::min( L[n], p0 + segL ) };
+			segments.push_back( segment );
+			sumL += segment.p1 - p0;
+			if( sumL >= tileL ){
+				tiles.push_back( segments.size() );
+				sumL = 0;
+			}
+		}
+	}
+	if( tiles.back() != segments.size() ){
+		tiles.push_back( segments.size() );
+	}
+
+	// the largest scores of each segment and motif
+	size_t M = sets.size();
+	std::vector<float> segMax( segments.size() * M, -FLT_MAX );
+
+	// the tiles are scored in blocks of consecutive tiles, one task per block
+	size_t blocks = std::min( tiles.size()-1, 4 * threads );
+
+	runTasks( blocks, [&]( size_t b ){
+
+		// buffers for the tiles of this block
+		uint8_t* seqBuf = NULL;
+		if( seqs->seqSource_ != NULL ){
+			seqBuf = ( uint8_t* )calloc( seqs->seqSource_->getMaxL(), sizeof( uint8_t ) );
+		}
+		std::vector<size_t> kmerBuf;			// k-mers of generated sequences
+		std::vector<size_t*> kmers;				// k-mers of the segment sequences
+		std::vector<size_t> yStart;				// offsets of the segments in y
+		std::vector<size_t> loStart;			// offsets of the segments in logOdds
+		std::vector<size_t> pos;				// offsets of the segments in mops
+		std::vector<size_t> posRC;				// offsets of the reverse strand windows in mops
+		std::vector<size_t> tail;				// k-mers after the end of each segment sequence
+		std::vector<size_t> tailKmer;
+		std::vector<size_t> y;
+		std::vector<float> logOdds;
+		std::vector<int32_t> logOdds32;			// sums of quantized scores
+		std::vector<int16_t> logOdds16;
+
+		size_t tEnd = ( tiles.size()-1 ) * ( b+1 ) / blocks;
+		for( size_t t = ( tiles.size()-1 ) * b / blocks; t < tEnd; t++ ){
+
+			size_t s0 = tiles[t];
+			size_t sT = tiles[t+1] - s0;
+			Segment* seg = segments.data() + s0;
+
+			// k-mers of the sequences, generated ones are written one after another
+			kmers.resize( sT );
+			yStart.resize( sT+1 );
+			yStart[0] = 0;
+			size_t genL = 0;
+			for( size_t s = 0; s < sT; s++ ){
+				genL += L[seg[s].n];
+				yStart[s+1] = yStart[s] + std::min( seg[s].p1 + maxW - 1, L[seg[s].n] ) + pad - seg[s].p0;
+			}
+			if( seqs->seqSource_ != NULL ){
+				kmerBuf.resize( genL );
+			}
+			tail.resize( sT * pad );
+			for( size_t s = 0, gen = 0; s < sT; s++ ){
+				kmers[s] = seqs->getKmer( seg[s].n, seqBuf, kmerBuf.data() + gen );
+				gen += L[seg[s].n];
+				if( pad > 0 ){
+					tailKmers( kmers[s], L[seg[s].n], L[seg[s].n], pad, tailKmer );
+					std::copy( tailKmer.begin(), tailKmer.end(), tail.begin() + s * pad );
+				}
+			}
+			y.resize( yStart[sT] );
+			loStart.resize( sT+1 );
+			pos.resize( sT );
+			posRC.resize( sT );
+
+			// the groups are sorted by order, extract the (K+1)-mers once per order
+			size_t yK = std::numeric_limits<size_t>::max();
+
+			for( size_t gr = 0; gr < groups.size(); gr++ ){
+
+				Group& group = groups[gr];
+				size_t G = group.members.size();
+				size_t W = group.W;
+				size_t Yk = Y[group.K+1];
+				const size_t* offset = group.offset;
+
+				if( group.K != yK ){
+					yK = group.K;
+					ExtractKmers extract = extractKmersKernels[kmerKernel( yK, Y[1] )];
+					for( size_t s = 0; s < sT; s++ ){
+						// the (K+1)-mers beyond the sequence end are taken from its tail
+						size_t ySeg = yStart[s+1] - yStart[s];
+						size_t yIn = std::min( ySeg, L[seg[s].n] - seg[s].p0 );
+						extract( kmers[s] + seg[s].p0, yIn, y.data() + yStart[s], Yk );
+						if( ySeg > yIn ){
+							extract( tail.data() + s * pad, ySeg - yIn, y.data() + yStart[s] + yIn, Yk );
+						}
+					}
+				}
+
+				// number of motif positions in each segment
+				loStart[0] = 0;
+				for( size_t s = 0; s < sT; s++ ){
+					size_t Ln = L[seg[s].n];
+					size_t end = ( Ln < W ) ? 0 : std::min( seg[s].p1, Ln - W + 1 );
+					loStart[s+1] = loStart[s] + ( ( end > seg[s].p0 ) ? end - seg[s].p0 : 0 );
+					pos[s] = offset[seg[s].n] + seg[s].p0;
+					// the reverse strand window of p0 starts at Ln - W - p0 on the reverse strand
+					if( revComp and end > seg[s].p0 ){
+						posRC[s] = offset[seg[s].n] + 2 * ( Ln - W + 1 ) - 1 - seg[s].p0;
+					}
+				}
+
+				// the forward strand, then the reverse strand from position K on
+				for( size_t strand = 0; strand < strands; strand++ ){
+					size_t sOff = strand * W * Yk * G;
+					const size_t* ys = y.data() + strand * group.K;
+					const size_t* ps = ( strand == 0 ) ? pos.data() : posRC.data();
+					if( qBits == 0 ){
+						scoreGroup( group.s.data() + sOff, G, W, Yk, group.cols, group.scale.data(),
+									group.shift.data(), group.members.data(), ys, yStart.data(),
+									loStart.data(), sT, ps, strand > 0, mops.data(), segMax.data() + s0 * M, M,
+									logOdds );
+					} else if( qBits == 16 ){
+						scoreGroup( group.s16.data() + sOff, G, W, Yk, group.cols, group.scale.data(),
+									group.shift.data(), group.members.data(), ys, yStart.data(),
+									loStart.data(), sT, ps, strand > 0, mops.data(), segMax.data() + s0 * M, M,
+									logOdds32 );
+					} else {
+						scoreGroup( group.s8.data() + sOff, G, W, Yk, group.cols, group.scale.data(),
+									group.shift.data(), group.members.data(), ys, yStart.data(),
+									loStart.data(), sT, ps, strand > 0, mops.data(), segMax.data() + s0 * M, M,
+									logOdds16 );
+					}
+				}
+			}
+		}
+
+		if( seqBuf ) free( seqBuf );
+	} );
+
+	// take the largest log odds score of the segments for ZOOPS model
+	parallelFor( M, [&]( size_t m ){
+		if( zoops[m] != NULL ){
+			std::fill( zoops[m], zoops[m] + N, -FLT_MAX );
+			for( size_t s = 0; s < segments.size(); s++ ){
+				if( segMax[s * M + m] > zoops[m][segments[s].n] ){
+					zoops[m][segments[s].n] = segMax[s * M + m];
+				}
+			}
+		}
+	} );
+}
+
+float ScoreSeqSet::quantizationError( size_t qBits ){
+
+	size_t K = motif_->getK();
+	size_t W = motif_->getW();
+	size_t K_bg = ( bg_->getOrder() < K ) ? bg_->getOrder() : K;
+	motif_->calculateLogS( bg_->getV(), K_bg );
+	float** s = motif_->getS();
+
+	// each quantized score is rounded by up to 0.5 / scale, where the scale maps
+	// the largest column range onto quantizedMax(); allow for float rounding
+	float range = 0.0f;
+	float absSum = 0.0f;
+	for( size_t j = 0; j < W; j++ ){
+		float colMax = -FLT_MAX;
+		float colMin = FLT_MAX;
+		for( size_t y = 0; y < Y_[K+1]; y++ ){
+			colMax = std::max( colMax, s[y][j] );
+			colMin = std::min( colMin, s[y][j] );
+		}
+		range = std::max( range, colMax - colMin );
+		absSum += std::max( fabsf( colMax ), fabsf( colMin ) );
+	}
+	return 0.5f * ( float )W * range / quantizedMax( qBits, W )
+		   + 8.0f * ( float )W * FLT_EPSILON * absSum;
+}
+
+void ScoreSeqSet::rescoreLogOdds( float* mops, std::vector<size_t> indices ){
+
+	size_t K = motif_->getK();
+	size_t W = motif_->getW();
+	size_t K_bg = ( bg_->getOrder() < K ) ? bg_->getOrder() : K;
+	motif_->calculateLogS( bg_->getV(), K_bg );
+	float** s = motif_->getS();
+	std::vector<float> sRC;
+	if( revComp_ ){
+		sRC = revCompTable( s, K, W, Y_[K+1] );
+	}
+
+	std::vector<size_t> offset( N_+1, 0 );
+	for( size_t n = 0; n < N_; n++ ){
+		offset[n+1] = offset[n] + getPositions( n, W );
+	}
+
+	// the sequences of the indices, each is read or generated once
+	std::sort( indices.begin(), indices.end() );
+	std::vector<size_t> seqs;
+	std::vector<size_t> first;
+	for( size_t k = 0; k < indices.size(); k++ ){
+		size_t n = std::upper_bound( offset.begin(), offset.end(), indices[k] ) - offset.begin() - 1;
+		if( seqs.empty() or n != seqs.back() ){
+			seqs.push_back( n );
+			first.push_back( k );
+		}
+	}
+	first.push_back( indices.size() );
+
+#pragma omp parallel
+	{
+		uint8_t* seqBuf = NULL;
+		size_t* kmerBuf = NULL;
+		if( seqSource_ != NULL ){
+			seqBuf = ( uint8_t* )calloc( seqSource_->getMaxL(), sizeof( uint8_t ) );
+			kmerBuf = ( size_t* )calloc( seqSource_->getMaxL(), sizeof( size_t ) );
+		}
+		std::vector<size_t> tail;
+
+#pragma omp for schedule(dynamic)
+		for( size_t r = 0; r < seqs.size(); r++ ){
+			size_t n = seqs[r];
+			size_t L = getL( n );
+			size_t LW1 = getLW1( n, W );
+			size_t* kmer = getKmer( n, seqBuf, kmerBuf );
+			if( revComp_ ){
+				tailKmers( kmer, L, L, K, tail );
+			}
+			for( size_t k = first[r]; k < first[r+1]; k++ ){
+				size_t i = indices[k] - offset[n];
+				float logOdds = 0.0f;
+				if( i < LW1 ){
+					for( size_t j = 0; j < W; j++ ){
+						logOdds += s[kmer[i+j] % Y_[K+1]][j];
+					}
+				} else {
+					// the reverse strand, at window L - W - ( i - LW1 ) of the forward strand
+					i = 2 * LW1 - 1 - i + K;
+					for( size_t j = 0; j < W; j++, i++ ){
+						size_t y = ( ( i < L ) ? kmer[i] : tail[i-L] ) % Y_[K+1];
+						logOdds += sRC[j * Y_[K+1] + y];
+					}
+				}
+				mops[indices[k]] = logOdds;
+			}
+		}
+
+		if( seqBuf ) free( seqBuf );
+		if( kmerBuf ) free( kmerBuf );
+	}
+}
+
+void ScoreSeqSet::rescoreQuantized( ScoreSeqSet* negSet, std::vector<float>& negScores,
+									ScoreSeqSet* posSet, std::vector<float>& posScores,
+									float pvalCutoff, size_t qBits ){
+
+	/**
+	 * a float score x differs from its quantized score by at most err, such that
+	 * all scores from the threshold T of the float scores on have quantized
+	 * scores above T' - 2 err, with T' the threshold of the quantized scores;
+	 * the same holds for the nTop+1 lowest negative scores of calcPvalues()
+	 */
+	size_t negN = negScores.size();
+	if( negN == 0 ){
+		return;
+	}
+	float err = negSet->quantizationError( qBits );
+	float high = calcScoreThreshold( negScores, pvalCutoff ) - 2.0f * err;
+	size_t nTop = std::min( 100, ( int )negN / 10 );
+	std::vector<float> lowest( negScores );
+	std::nth_element( lowest.begin(), lowest.begin() + nTop, lowest.end() );
+	float low = lowest[nTop] + 2.0f * err;
+	std::vector<float>().swap( lowest );
+
+	std::vector<size_t> negIndices;
+	for( size_t i = 0; i < negN; i++ ){
+		if( negScores[i] >= high or negScores[i] <= low ){
+			negIndices.push_back( i );
+		}
+	}
+	std::vector<size_t> posIndices;
+	for( size_t i = 0; i < posScores.size(); i++ ){
+		if( posScores[i] >= high ){
+			posIndices.push_back( i );
+		}
+	}
+	negSet->rescoreLogOdds( negScores.data(), negIndices );
+	posSet->rescoreLogOdds( posScores.data(), posIndices );
+}
+
+void ScoreSeqSet::calcHits( float minScore ){
+
 	size_t K = motif_->getK();
 	size_t W = motif_->getW();
 	size_t K_bg = ( bg_->getOrder() < K ) ? bg_->getOrder() : K;
@@ -35,54 +731,343 @@ void ScoreSeqSet::calcLogOdds(){
 	motif_->calculateLogS( bg_->getV(), K_bg );
 	float** s = motif_->getS();
 
-	mops_scores_.resize( seqSet_.size() );
+	// the score tables of the forward and the reverse strand, t[j * Y[K+1] + y]
+	size_t A = Y_[1];
+	size_t YK = Y_[K];
+	size_t YK1 = Y_[K+1];
+	std::vector<float> sF( W * YK1 );
+	for( size_t j = 0; j < W; j++ ){
+		for( size_t y = 0; y < YK1; y++ ){
+			sF[j * YK1 + y] = s[y][j];
+		}
+	}
+	std::vector<float> sRC;
+	if( revComp_ ){
+		sRC = revCompTable( s, K, W, YK1 );
+	}
+	float absSum;
+	std::vector<float> R = lookahead( sF, W, A, YK, absSum );
+	std::vector<float> RRC;
+	if( revComp_ ){
+		RRC = lookahead( sRC, W, A, YK, absSum );
+	}
+	// allow for rounding differences between the bound and the summed scores
+	float bound = minScore - 4.0f * ( float )W * FLT_EPSILON * absSum;
+
+	hit_positions_.assign( N_, std::vector<size_t>() );
+	hit_scores_.assign( N_, std::vector<float>() );
+	hits_only_ = true;
+
+	typedef void ( ScoreSeqSet::*ScanHits )( float, float, const float*, const float*,
+											 const float*, const float* );
+	static const ScanHits kernels[] = { &ScoreSeqSet::scanHits<0,0>,
+		&ScoreSeqSet::scanHits<0,4>, &ScoreSeqSet::scanHits<1,4>, &ScoreSeqSet::scanHits<2,4>,
+		&ScoreSeqSet::scanHits<3,4>, &ScoreSeqSet::scanHits<4,4>, &ScoreSeqSet::scanHits<5,4> };
+	( this->*kernels[kmerKernel( K, A )] )( minScore, bound, sF.data(), R.data(), sRC.data(), RRC.data() );
+}
+
+template<size_t K, size_t A>
+void ScoreSeqSet::scanHits( float minScore, float bound, const float* s, const float* R,
+							const float* sRC, const float* RRC ){
+
+	size_t W = motif_->getW();
+	size_t pad = revComp_ ? motif_->getK() : 0;
+	const size_t YK = ( A > 0 ) ? cpow( A, K ) : Y_[motif_->getK()];
+	const size_t YK1 = ( A > 0 ) ? cpow( A, K+1 ) : Y_[motif_->getK()+1];
+
+	// sum up the scores of table t at the (K+1)-mers of kmer after the context c,
+	// until the window is complete or the bound shows that it cannot reach minScore
+	auto scan = [&]( const float* t, const float* bnd, const size_t* kmer, size_t c, float& logOdds ){
+		logOdds = 0.0f;
+		for( size_t j = 0; j < W; j++ ){
+			if( logOdds + bnd[j * YK + c] < bound ){
+				return false;
+			}
+			size_t y = kmer[j] % YK1;
+			logOdds += t[j * YK1 + y];
+			c = y % YK;
+		}
+		return logOdds >= minScore;
+	};
+
+#pragma omp parallel
+	{
+		// thread-local buffers for sequences generated on demand
+		uint8_t* seqBuf = NULL;
+		size_t* kmerBuf = NULL;
+		if( seqSource_ != NULL ){
+			seqBuf = ( uint8_t* )calloc( seqSource_->getMaxL(), sizeof( uint8_t ) );
+			kmerBuf = ( size_t* )calloc( seqSource_->getMaxL(), sizeof( size_t ) );
+		}
+		std::vector<size_t> tail;
+
+#pragma omp for schedule(dynamic)
+		for( size_t n = 0; n < N_; n++ ){
+
+			size_t	L = getL( n );
+			size_t	LW1 = getLW1( n, W );
+			size_t* kmer = getKmer( n, seqBuf, kmerBuf );
+			float	logOdds;
+
+			for( size_t i = 0; i < LW1; i++ ){
+				if( scan( s, R, kmer + i, ( i > 0 ) ? kmer[i-1] % YK : 0, logOdds ) ){
+					hit_positions_[n].push_back( i );
+					hit_scores_[n].push_back( logOdds );
+				}
+			}
+
+			if( revComp_ ){
+				// the reverse strand from its start on, the windows from position b
+				// on read the k-mers after the sequence end from the tail
+				size_t b = ( L > W + pad ) ? L - W - pad : 0;
+				tailKmers( kmer, L, b, pad, tail );
+				for( size_t r = 0; r < LW1; r++ ){
+					size_t i = LW1 - 1 - r;
+					const size_t* y = ( i < b ) ? kmer + i + pad : tail.data() + i + pad - b;
+					if( scan( sRC, RRC, y, ( YK > 1 ) ? y[-1] % YK : 0, logOdds ) ){
+						hit_positions_[n].push_back( LW1 + r );
+						hit_scores_[n].push_back( logOdds );
+					}
+				}
+			}
+		}
+
+		if( seqBuf ) free( seqBuf );
+		if( kmerBuf ) free( kmerBuf );
+	}
+}
+
+void ScoreSeqSet::calcSeededHits( float minScore, SeqIndex* index ){
+
+	size_t K = motif_->getK();
+	size_t W = motif_->getW();
+	size_t q = index->getQ();
+
+	// the seeds need the sequences of the index and q letters to hold a (K+1)-mer
+	if( revComp_ or seqSource_ != NULL or W < q or K >= q ){
+		calcHits( minScore );
+		return;
+	}
+	if( index->getN() != N_ ){
+		std::cerr << "Error: The sequence index does not belong to the scanned sequences." << std::endl;
+		exit( 1 );
+	}
+
+	size_t K_bg = ( bg_->getOrder() < K ) ? bg_->getOrder() : K;
+	motif_->calculateLogS( bg_->getV(), K_bg );
+	float** s = motif_->getS();
+
+	size_t A = Y_[1];
+	size_t YK = Y_[K];
+	size_t YK1 = Y_[K+1];
+	std::vector<float> sF( W * YK1 );
+	for( size_t j = 0; j < W; j++ ){
+		for( size_t y = 0; y < YK1; y++ ){
+			sF[j * YK1 + y] = s[y][j];
+		}
+	}
+	float absSum;
+	std::vector<float> R = lookahead( sF, W, A, YK, absSum );
+	float bound = minScore - 4.0f * ( float )W * FLT_EPSILON * absSum;
+
+	/**
+	 * a window reaches minScore only if its q letters at the columns c, ..., c+q-1
+	 * allow it to: the columns c+K, ..., c+q-1 are scored by these letters alone,
+	 * the columns before are bounded by the best score P[c+K] of any letters and
+	 * the columns after by the lookahead bound R[c+q] of the last K letters. The
+	 * seeds are the q-mers which pass at the column c with the fewest positions
+	 * in the index; only the windows at their positions are scored.
+	 */
+	std::vector<float> P( W+1, 0.0f );
+	std::vector<float> F( YK, 0.0f );
+	for( size_t j = 0; j < W; j++ ){
+		std::vector<float> next( YK, -FLT_MAX );
+		for( size_t y = 0; y < YK1; y++ ){
+			next[y % YK] = std::max( next[y % YK], F[y / A] + sF[j * YK1 + y] );
+		}
+		F.swap( next );
+		P[j+1] = *std::max_element( F.begin(), F.end() );
+	}
+
+	// the q-mers passing at column c, unless their positions exceed maxCount
+	auto enumerateSeeds = [&]( size_t c, size_t maxCount, std::vector<size_t>& seeds, size_t& count ){
+
+		// H[d][ctx]: the best score of the seed columns from d on and the columns after the seed
+		std::vector<float> H( ( q+1 ) * YK );
+		std::copy( R.begin() + ( c+q ) * YK, R.begin() + ( c+q+1 ) * YK, H.begin() + q * YK );
+		for( size_t d = q; d-- > 0; ){
+			for( size_t ctx = 0; ctx < YK; ctx++ ){
+				float best = -FLT_MAX;
+				for( size_t a = 0; a < A; a++ ){
+					size_t y = ctx * A + a;
+					best = std::max( best, ( ( d >= K ) ? sF[( c+d ) * YK1 + y] : 0.0f )
+										   + H[( d+1 ) * YK + y % YK] );
+				}
+				H[d * YK + ctx] = best;
+			}
+		}
 
-//#pragma omp parallel for
-	for( size_t n = 0; n < seqSet_.size(); n++ ){
+		// depth-first over the letters of the seeds, the letters before column c+K are not scored
+		seeds.clear();
+		count = 0;
+		float base = P[c+K];
+		std::vector<size_t> a( q, 0 ), ctx( q, 0 ), x( q, 0 );
+		std::vector<float> sum( q, 0.0f );
+		for( size_t d = 0; ; ){
+			if( a[d] == A ){
+				if( d == 0 ){
+					break;
+				}
+				a[--d]++;
+				continue;
+			}
+			size_t y = ctx[d] * A + a[d];
+			float partial = sum[d] + ( ( d >= K ) ? sF[( c+d ) * YK1 + y] : 0.0f );
+			if( base + partial + H[( d+1 ) * YK + y % YK] < bound ){
+				a[d]++;
+			} else if( d + 1 == q ){
+				size_t n;
+				index->getPositions( x[d] * A + a[d], n );
+				count += n;
+				if( count > maxCount ){
+					return false;
+				}
+				seeds.push_back( x[d] * A + a[d] );
+				a[d]++;
+			} else {
+				sum[d+1] = partial;
+				ctx[d+1] = y % YK;
+				x[d+1] = x[d] * A + a[d];
+				a[++d] = 0;
+			}
+		}
+		return true;
+	};
+
+	// seeding pays off if it leaves a small part of the positions, else scan all
+	size_t best = index->getStart( N_ ) / 4;
+	size_t seedColumn = W;
+	std::vector<size_t> seeds, bestSeeds;
+	for( size_t c = 0; c + q <= W; c++ ){
+		size_t count;
+		if( enumerateSeeds( c, best, seeds, count ) ){
+			best = count;
+			seedColumn = c;
+			bestSeeds.swap( seeds );
+		}
+	}
+	if( seedColumn == W ){
+		calcHits( minScore );
+		return;
+	}
+
+	// the starts of the windows at the seeds, and at the q-mers with unknown letters
+	std::vector<uint64_t> windows;
+	for( size_t k = 0; k < bestSeeds.size(); k++ ){
+		size_t n;
+		const uint64_t* positions = index->getPositions( bestSeeds[k], n );
+		for( size_t m = 0; m < n; m++ ){
+			windows.push_back( positions[m] );
+		}
+	}
+	for( auto& range : index->getUnknown() ){
+		for( uint64_t p = range.first; p < range.second; p++ ){
+			windows.push_back( p );
+		}
+	}
+	parallelSort( windows, std::less<uint64_t>() );
+
+	hit_positions_.assign( N_, std::vector<size_t>() );
+	hit_scores_.assign( N_, std::vector<float>() );
+	hits_only_ = true;
+
+#pragma omp parallel for schedule(dynamic)
+	for( size_t n = 0; n < N_; n++ ){
 
-		size_t 	LW1 = seqSet_[n]->getL() - W + 1;
+		size_t L = getL( n );
+		size_t LW1 = getLW1( n, W );
 		size_t* kmer = seqSet_[n]->getKmer();
-		float 	maxScore = -FLT_MAX;
-        //float   maxScore = 0.f;
 
-        size_t z_i = 0;
-		for( size_t i = 0; i < LW1; i++ ){
+		// the seeds of sequence n, in the order of their positions
+		uint64_t start = index->getStart( n );
+		auto first = std::lower_bound( windows.begin(), windows.end(), start );
+		auto last = std::lower_bound( first, windows.end(), start + L );
+
+		for( auto w = first; w != last; w++ ){
+			size_t p = *w - start;
+			if( p < seedColumn or p - seedColumn >= LW1 ){
+				continue;
+			}
+			size_t i = p - seedColumn;
 			float logOdds = 0.0f;
-			for( size_t j = 0; j < W; j++ ){
-				size_t y = kmer[i+j] % Y_[K+1];
-				logOdds += s[y][j];
+			size_t c = ( i > 0 ) ? kmer[i-1] % YK : 0;
+			size_t j = 0;
+			for( ; j < W; j++ ){
+				if( logOdds + R[j * YK + c] < bound ){
+					break;
+				}
+				size_t y = kmer[i+j] % YK1;
+				logOdds += sF[j * YK1 + y];
+				c = y % YK;
 			}
-			// take all the log odds scores for MOPS model:
-			mops_scores_[n].push_back( logOdds );
-
-			// take the largest log odds score for ZOOPS model:
-            if( logOdds > maxScore ){
-                maxScore = logOdds;
-                z_i = i;
-            }
-        }
-		zoops_scores_.push_back( maxScore );
-        z_.push_back( z_i );
+			if( j == W and logOdds >= minScore ){
+				hit_positions_[n].push_back( i );
+				hit_scores_[n].push_back( logOdds );
+			}
+		}
+	}
+}
+
+float ScoreSeqSet::calcScoreThreshold( std::vector<float> neg_all_scores, float pvalCutoff ){
+
+	/**
+	 * positions with at least F = ceil( pvalCutoff * negN ) + 1 higher negative
+	 * scores get a p-value of at least F - 1 over negN, i.e. not below the cutoff;
+	 * the threshold is the F-th highest negative score
+	 */
+	size_t negN = neg_all_scores.size();
+	size_t F = ( size_t )ceilf( pvalCutoff * ( float )negN ) + 1;
+	if( F > negN ){
+		return -FLT_MAX;
 	}
+	std::nth_element( neg_all_scores.begin(), neg_all_scores.begin() + ( negN - F ), neg_all_scores.end() );
+	return neg_all_scores[negN - F];
+}
+
+float ScoreSeqSet::calcScoreThresholdSorted( const std::vector<float>& neg_all_scores, float pvalCutoff ){
+
+	// the F-th highest negative score, see calcScoreThreshold()
+	size_t negN = neg_all_scores.size();
+	size_t F = ( size_t )ceilf( pvalCutoff * ( float )negN ) + 1;
+	if( F > negN ){
+		return -FLT_MAX;
+	}
+	return neg_all_scores[negN - F];
 }
 
 // compute p_values for motif scores based on negative sequence scores
 void ScoreSeqSet::calcPvalues( std::vector<std::vector<float>> pos_scores, std::vector<float> neg_all_scores ){
 
+    // sort negative set scores in ascending order
+    parallelSort( neg_all_scores, std::less<float>() );
+
+    calcPvaluesSorted( std::move( pos_scores ), neg_all_scores );
+}
+
+void ScoreSeqSet::calcPvaluesSorted( std::vector<std::vector<float>> pos_scores,
+									 const std::vector<float>& neg_all_scores ){
+
 	/**
 	 * calculate P-values for motif occurrences
 	 */
 
-    size_t posN = seqSet_.size();
+    size_t posN = N_;
     size_t negN = neg_all_scores.size();
     mops_p_values_.resize( posN );
     mops_e_values_.resize( posN );
 
     float eps = 1.0e-5;
 
-    // sort negative set scores in ascending order
-    std::sort( neg_all_scores.begin(), neg_all_scores.end(), std::less<float>() );
-
     // get the top n-th score from the negative set
     size_t nTop = std::min( 100, ( int )negN / 10 );
     float S_ntop = neg_all_scores[nTop];
@@ -95,9 +1080,11 @@ void ScoreSeqSet::calcPvalues( std::vector<std::vector<float>> pos_scores, std::
 	lambda = lambda / ( float )nTop;
 
 #pragma omp parallel for
-	for( size_t n = 0; n < seqSet_.size(); n++ ){
+	for( size_t n = 0; n < N_; n++ ){
 
-		size_t LW1 = seqSet_[n]->getL() - motif_->getW() + 1;
+		size_t LW1 = pos_scores[n].size();
+		mops_p_values_[n].resize( LW1 );
+		mops_e_values_[n].resize( LW1 );
 
 		for( size_t i = 0; i < LW1; i++ ){
 
@@ -120,8 +1107,8 @@ void ScoreSeqSet::calcPvalues( std::vector<std::vector<float>> pos_scores, std::
 				float SlLower = neg_all_scores[negN-FPl];
 				p_value = ( ( float )FPl + ( SlHigher - Sl + eps ) / ( SlHigher - SlLower + eps ) ) / ( float )negN;
 			}
-            mops_p_values_[n].push_back( p_value );
-            mops_e_values_[n].push_back( p_value * ( float )posN );
+            mops_p_values_[n][i] = p_value;
+            mops_e_values_[n][i] = p_value * ( float )posN;
 		}
 	}
 
@@ -220,6 +1207,9 @@ void ScoreSeqSet::calcPvalues( std::vector<std::vector<float>> pos_scores, std::
 		}
 	}
 */
+    if( keep_scores_ ){
+        p_value_scores_.swap( pos_scores );
+    }
     pval_is_calulated_ = true;
 }
 
@@ -231,8 +1221,12 @@ std::vector<float> ScoreSeqSet::getZoopsScores(){
 	return zoops_scores_;
 }
 
+std::vector<std::vector<float>> ScoreSeqSet::getHitScores(){
+	return hit_scores_;
+}
+
 void ScoreSeqSet::printLogOdds(){
-    for( size_t n = 0; n < seqSet_.size(); n++ ){
+    for( size_t n = 0; n < N_; n++ ){
         std::cout << "seq " << n << ":" << std::endl;
         std::cout << zoops_scores_[n] << '\t';
         for( size_t i = 0; i < mops_scores_[n].size(); i++ ){
@@ -242,52 +1236,215 @@ void ScoreSeqSet::printLogOdds(){
     }
 }
 
-void ScoreSeqSet::write( char* odir, std::string basename, float pvalCutoff, bool ss ){
+// the region of a header chr:start-end, optionally followed by (+) or (-) for its
+// strand, as written by bedtools getfasta; otherwise the chromosome is the name of
+// the sequence, i.e. the header without '>' up to the first space, at 0..0 on '+'
+static bool parseRegion( const std::string& header, std::string& chrom,
+						 size_t& start, size_t& end, char& strand ){
+
+	std::string name = header.substr( ( !header.empty() and header[0] == '>' ) ? 1 : 0 );
+	name = name.substr( 0, name.find_first_of( " \t" ) );
+
+	chrom = name;
+	start = end = 0;
+	strand = '+';
+
+	size_t colon = name.rfind( ':' );
+	if( colon == std::string::npos or colon == 0 ){
+		return false;
+	}
+	std::string range = name.substr( colon + 1 );
+	char rangeStrand = '+';
+	if( range.size() > 3 and range[range.size()-3] == '(' and range[range.size()-1] == ')' ){
+		rangeStrand = range[range.size()-2];
+		if( rangeStrand != '+' and rangeStrand != '-' ){
+			return false;
+		}
+		range.resize( range.size() - 3 );
+	}
+	size_t dash = range.find( '-' );
+	if( dash == std::string::npos or dash == 0 or dash + 1 == range.size()
+		or range.find_first_not_of( "0123456789-" ) != std::string::npos
+		or range.find( '-', dash + 1 ) != std::string::npos ){
+		return false;
+	}
+
+	chrom = name.substr( 0, colon );
+	start = std::stoull( range.substr( 0, dash ) );
+	end = std::stoull( range.substr( dash + 1 ) );
+	strand = rangeStrand;
+	return true;
+}
+
+void ScoreSeqSet::write( char* odir, std::string basename, float pvalCutoff, bool ss, std::string format ){
 
     /**
-	 * save log odds scores in one flat file:
-	 * basename.occurrence
+	 * save the motif occurrences with p-values below the cutoff in one file:
+	 * basename.occurrence		tab-separated text, see the header line
+	 * basename.bed				BED6 with the pattern as name and -10*log10(p-value) as
+	 *							score, plus p-value and e-value; for headers chr:start-end
+	 *							as from bedtools getfasta, with an optional (+) or (-),
+	 *							in genomic coordinates, otherwise on the sequences
+	 * basename.occurrence.bin	columnar table: "BaMMocc\2", then W, the number of
+	 *							sequences N and of occurrences R as uint64_t; N+1 offsets
+	 *							as uint64_t of the headers in the following letters,
+	 *							padded to 8 bytes; then the columns sequence number and
+	 *							forward-strand start as uint32_t, log-odds score, p-value
+	 *							and e-value as float, and the strand as '+' or '-'
 	 */
 
+	bool bed = ( format == "bed" );
+	bool binary = ( format == "binary" );
+
+	std::string opath = std::string( odir )  + '/' + basename
+						+ ( bed ? ".bed" : ( binary ? ".occurrence.bin" : ".occurrence" ) );
+
+	RecordWriter ofile( opath );
+
+	write( ofile, pvalCutoff, ss, format );
+}
+
+void ScoreSeqSet::write( RecordWriter& ofile, float pvalCutoff, bool ss, std::string format ){
+
     assert( pval_is_calulated_ );
 
-	size_t 	end; 				// end of motif match
+	bool bed = ( format == "bed" );
+	bool binary = ( format == "binary" );
 
-	std::string opath = std::string( odir )  + '/' + basename + ".occurrence";
+	size_t W = motif_->getW();
 
-	std::ofstream ofile( opath );
+	if( binary ){
+		writeColumns( ofile, pvalCutoff, ss );
+		return;
+	}
 
-    // add a header to the results
-    ofile << "seq\tlength\tstrand\tstart..end\tpattern\tp-value\te-value" << std::endl;
+	if( !bed ){
+		// add a header to the results
+		ofile.put( "seq\tlength\tstrand\tstart..end\tpattern\tp-value\te-value\n" );
+	}
 
-	for( size_t n = 0; n < seqSet_.size(); n++ ){
-		size_t seqlen = seqSet_[n]->getL();
-		if( !ss ){
-			seqlen = ( seqlen - 1 ) / 2;
+	uint8_t* seqBuf = NULL;
+	size_t* kmerBuf = NULL;
+	if( seqSource_ != NULL ){
+		seqBuf = ( uint8_t* )calloc( seqSource_->getMaxL(), sizeof( uint8_t ) );
+		kmerBuf = ( size_t* )calloc( seqSource_->getMaxL(), sizeof( size_t ) );
+	}
+
+	for( size_t n = 0; n < N_; n++ ){
+		size_t seqlen = getSeqLength( n, ss );
+		size_t LW1 = getLW1( n, W );
+		// all positions, or only the hits of a threshold scan
+		size_t P = mops_p_values_[n].size();
+		getKmer( n, seqBuf, kmerBuf );
+		uint8_t* sequence = getSequence( n, seqBuf );
+		std::string header = getHeader( n );
+
+		std::string chrom;
+		size_t regionStart = 0;
+		size_t regionEnd = 0;
+		char regionStrand = '+';
+		if( bed ){
+			parseRegion( header, chrom, regionStart, regionEnd, regionStrand );
 		}
-		size_t LW1 = seqSet_[n]->getL() - motif_->getW() + 1;
 
-        for( size_t i = 0; i < LW1; i++ ){
+        for( size_t k = 0; k < P; k++ ){
+
+			size_t i = hits_only_ ? hit_positions_[n][k] : k;
+
+			if( mops_p_values_[n][k] < pvalCutoff ){
+
+				if( bed ){
+					size_t start;
+					char strand = getSite( seqlen, LW1, i, start );
+					if( start + W > seqlen ){
+						continue;	// across the separator to the reverse complement
+					}
+					if( regionStrand == '-' ){
+						// the sequence is the reverse complement of the region
+						start = regionEnd - start - W;
+						strand = ( strand == '+' ) ? '-' : '+';
+					} else {
+						start += regionStart;
+					}
+					float score = -10.f * log10f( mops_p_values_[n][k] );
+					score = ( score > 1000.f ) ? 1000.f : ( ( score > 0.f ) ? score : 0.f );
+					ofile.put( chrom ).put( '\t' ).put( start ).put( '\t' ).put( start + W ).put( '\t' );
+					writePattern( ofile, sequence, seqlen, LW1, i );
+					ofile.put( '\t' ).put( static_cast<size_t>( score + 0.5f ) ).put( '\t' ).put( strand )
+						 .put( '\t' ).put( mops_p_values_[n][k], 3 )
+						 .put( '\t' ).put( mops_e_values_[n][k], 3 ).put( '\n' );
+				} else {
+					// >header:sequence_length
+					ofile.put( header ).put( '\t' ).put( seqlen ).put( '\t' );
+
+					// start:end:score:strand:sequence_matching
+					writeSite( ofile, sequence, seqlen, LW1, i );
+					ofile.put( '\t' ).put( mops_p_values_[n][k], 3 )
+						 .put( '\t' ).put( mops_e_values_[n][k], 3 ).put( '\n' );
+				}
+			}
+		}
+	}
 
-			if( mops_p_values_[n][i] < pvalCutoff ){
-                // >header:sequence_length
-                ofile << seqSet_[n]->getHeader() << '\t' << seqlen << '\t';
+	if( seqBuf ) free( seqBuf );
+	if( kmerBuf ) free( kmerBuf );
 
-				// start:end:score:strand:sequence_matching
-				end = i + motif_->getW();
+}
 
-				ofile << ( ( i < seqlen ) ? '+' : '-' ) << '\t'
-                      << i+1 << ".." << end << '\t';
-				for( size_t m = i; m < end; m++ ){
-					ofile << Alphabet::getBase( seqSet_[n]->getSequence()[m] );
-				}
-				ofile << '\t' << std::setprecision( 3 )
-                      << mops_p_values_[n][i] << '\t'
-                      << mops_e_values_[n][i] << std::endl;
+void ScoreSeqSet::writeColumns( RecordWriter& ofile, float pvalCutoff, bool ss ){
+
+	assert( keep_scores_ );
+
+	size_t W = motif_->getW();
+
+	// the columns of the occurrences below the p-value cutoff
+	std::vector<uint32_t> seqs;
+	std::vector<uint32_t> starts;
+	std::vector<float> scores;
+	std::vector<float> pValues;
+	std::vector<float> eValues;
+	std::vector<char> strands;
+	for( size_t n = 0; n < N_; n++ ){
+		size_t seqlen = getSeqLength( n, ss );
+		size_t LW1 = getLW1( n, W );
+		for( size_t k = 0; k < mops_p_values_[n].size(); k++ ){
+			if( mops_p_values_[n][k] < pvalCutoff ){
+				size_t start;
+				strands.push_back( getSite( seqlen, LW1, hits_only_ ? hit_positions_[n][k] : k, start ) );
+				seqs.push_back( static_cast<uint32_t>( n ) );
+				starts.push_back( static_cast<uint32_t>( start ) );
+				scores.push_back( p_value_scores_[n][k] );
+				pValues.push_back( mops_p_values_[n][k] );
+				eValues.push_back( mops_e_values_[n][k] );
 			}
 		}
 	}
 
+	uint64_t values[3] = { W, N_, seqs.size() };
+	ofile.putBinary( "BaMMocc\2", 8 ).putBinary( values, sizeof( values ) );
+
+	std::vector<std::string> headers( N_ );
+	uint64_t offset = 0;
+	ofile.putBinary( &offset, sizeof( offset ) );
+	for( size_t n = 0; n < N_; n++ ){
+		headers[n] = getHeader( n );
+		offset += headers[n].size();
+		ofile.putBinary( &offset, sizeof( offset ) );
+	}
+	for( size_t n = 0; n < N_; n++ ){
+		ofile.put( headers[n] );
+	}
+	uint64_t padding = 0;
+	ofile.putBinary( &padding, ( 8 - offset % 8 ) % 8 );
+
+	if( !seqs.empty() ){
+		ofile.putBinary( seqs.data(), seqs.size() * sizeof( uint32_t ) );
+		ofile.putBinary( starts.data(), starts.size() * sizeof( uint32_t ) );
+		ofile.putBinary( scores.data(), scores.size() * sizeof( float ) );
+		ofile.putBinary( pValues.data(), pValues.size() * sizeof( float ) );
+		ofile.putBinary( eValues.data(), eValues.size() * sizeof( float ) );
+		ofile.putBinary( strands.data(), strands.size() );
+	}
 }
 
 void ScoreSeqSet::writeLogOdds( char* odir, std::string basename, bool ss ){
@@ -297,35 +1454,113 @@ void ScoreSeqSet::writeLogOdds( char* odir, std::string basename, bool ss ){
 	 * basename.logOddsZoops
 	 */
 
-    size_t 	end; 				// end of motif match
-
     std::string opath = std::string( odir )  + '/' + basename + ".logOddsZoops";
 
-    std::ofstream ofile( opath );
+    RecordWriter ofile( opath );
 
     // add a header to the results
-    ofile << "seq\tlength\tstrand\tstart..end\tpattern\tzoops_score" << std::endl;
+    ofile.put( "seq\tlength\tstrand\tstart..end\tpattern\tzoops_score\n" );
 
-    for( size_t n = 0; n < seqSet_.size(); n++ ){
-        size_t seqlen = seqSet_[n]->getL();
-        if( !ss ){
-            seqlen = ( seqlen - 1 ) / 2;
-        }
+    uint8_t* seqBuf = NULL;
+    size_t* kmerBuf = NULL;
+    if( seqSource_ != NULL ){
+        seqBuf = ( uint8_t* )calloc( seqSource_->getMaxL(), sizeof( uint8_t ) );
+        kmerBuf = ( size_t* )calloc( seqSource_->getMaxL(), sizeof( size_t ) );
+    }
+
+    for( size_t n = 0; n < N_; n++ ){
+        size_t seqlen = getSeqLength( n, ss );
+        getKmer( n, seqBuf, kmerBuf );
+        uint8_t* sequence = getSequence( n, seqBuf );
 
         // >header:sequence_length
-        ofile << seqSet_[n]->getHeader() << '\t' << seqlen << '\t';
+        ofile.put( getHeader( n ) ).put( '\t' ).put( seqlen ).put( '\t' );
 
         // start:end:score:strand:sequence_matching
-        end = z_[n] + motif_->getW();
+        writeSite( ofile, sequence, seqlen, getLW1( n, motif_->getW() ), z_[n] );
+        ofile.put( '\t' ).put( zoops_scores_[n], 3 ).put( '\n' );
+    }
 
-        ofile << ( ( z_[n] < seqlen ) ? '+' : '-' ) << '\t'
-              << z_[n]+1 << ".." << end << '\t';
-        for( size_t m = z_[n]; m < end; m++ ){
-            ofile << Alphabet::getBase( seqSet_[n]->getSequence()[m] );
-        }
-        ofile << '\t' << std::setprecision( 3 ) << zoops_scores_[n] << std::endl;
+    if( seqBuf ) free( seqBuf );
+    if( kmerBuf ) free( kmerBuf );
 
+}
 
-    }
+char ScoreSeqSet::getSite( size_t seqlen, size_t LW1, size_t i, size_t& start ){
+
+	size_t W = motif_->getW();
+
+	if( revComp_ and i >= LW1 ){
+		// reverse strand positions follow the forward ones in ascending order
+		start = seqlen - W - ( i - LW1 );
+		return '-';
+	}
+	if( i < seqlen ){
+		start = i;
+		return '+';
+	}
+	// the reverse complement is stored after the forward strand and a separator
+	start = 2 * seqlen + 1 - W - i;
+	return '-';
+}
+
+void ScoreSeqSet::writeSite( RecordWriter& ofile, uint8_t* sequence, size_t seqlen, size_t LW1, size_t i ){
+
+	size_t W = motif_->getW();
+
+	// report the reverse strand at its position after the forward strand and a
+	// separator, as for sequences stored with their reverse complements
+	size_t start;
+	char strand = getSite( seqlen, LW1, i, start );
+	if( strand == '-' ){
+		start = 2 * seqlen + 1 - W - start;
+	}
+	ofile.put( strand ).put( '\t' ).put( start + 1 ).put( ".." ).put( start + W ).put( '\t' );
+	writePattern( ofile, sequence, seqlen, LW1, i );
+}
+
+void ScoreSeqSet::writePattern( RecordWriter& ofile, uint8_t* sequence, size_t seqlen, size_t LW1, size_t i ){
+
+	size_t W = motif_->getW();
+
+	if( revComp_ and i >= LW1 ){
+		size_t f = seqlen - W - ( i - LW1 );
+		for( size_t m = f + W; m-- > f; ){
+			ofile.put( Alphabet::getBase( sequence[m] ? Alphabet::getComplementCode( sequence[m] ) : 0 ) );
+		}
+		return;
+	}
+	for( size_t m = i; m < i + W; m++ ){
+		ofile.put( Alphabet::getBase( sequence[m] ) );
+	}
+}
+
+size_t ScoreSeqSet::getSeqLength( size_t n, bool ss ){
+	size_t L = getL( n );
+	return ( !ss and !revComp_ ) ? ( L - 1 ) / 2 : L;
+}
+
+size_t ScoreSeqSet::getLW1( size_t n, size_t W ){
+	size_t L = getL( n );
+	return ( L < W ) ? 0 : L - W + 1;
+}
+
+size_t ScoreSeqSet::getL( size_t n ){
+	return ( seqSource_ != NULL ) ? seqSource_->getL( n * stride_ ) : seqSet_[n]->getL();
+}
+
+std::string ScoreSeqSet::getHeader( size_t n ){
+	return ( seqSource_ != NULL ) ? seqSource_->getHeader( n * stride_ ) : seqSet_[n]->getHeader();
+}
+
+size_t* ScoreSeqSet::getKmer( size_t n, uint8_t* seqBuf, size_t* kmerBuf ){
+	if( seqSource_ != NULL ){
+		seqSource_->generate( n * stride_, seqBuf, kmerBuf );
+		return kmerBuf;
+	}
+	return seqSet_[n]->getKmer();
+}
 
+uint8_t* ScoreSeqSet::getSequence( size_t n, uint8_t* seqBuf ){
+	return ( seqSource_ != NULL ) ? seqBuf : seqSet_[n]->getSequence();
 }
@@ -10,6 +10,9 @@
 
 #include "../init/Motif.h"
 #include "../init/BackgroundModel.h"
+#include "../init/SeqSource.h"
+#include "../init/RecordWriter.h"
+#include "SeqIndex.h"
 
 class ScoreSeqSet{
 	/*
@@ -24,15 +27,72 @@ class ScoreSeqSet{
 public:
 
 	ScoreSeqSet( Motif* motif, BackgroundModel* bg, std::vector<Sequence*> seqSet );
+	// score the sequences 0, stride, 2*stride, ... of a lazily generated set,
+	// each sequence is generated, scored and discarded
+	ScoreSeqSet( Motif* motif, BackgroundModel* bg, SeqSource* seqSource, size_t stride = 1 );
 	~ScoreSeqSet();
 
+	// also score the reverse strands of sequences which are stored without their reverse
+	// complements: a reverse-complemented copy of the score table is applied to the same
+	// (K+1)-mers, such that both strands are scored in one pass over the forward strand.
+	// The scores of sequence n are those of its forward strand followed by those of its
+	// reverse strand, from the start of the reverse strand on
+	void setRevComp( bool revComp );
+	// keep the scores given to calcPvalues() for the score column of write( ..., "binary" )
+	void setKeepScores( bool keepScores );
+	// number of scored positions of sequence n for a motif of width W
+	size_t getPositions( size_t n, size_t W );
+
 	void calcLogOdds();
+	// write the scores into caller-provided buffers instead of the member vectors:
+	// the scores of all positions go consecutively sequence by sequence into mops,
+	// the maximal score of sequence n into zoops[n]; either buffer may be NULL
+	void calcLogOdds( float* mops, float* zoops );
+	// the same for the motifs of several sets on the same sequences, in a single pass
+	// over the sequences: each sequence is read or generated once and scored with all
+	// motifs, grouped by order and width; mops[m] and zoops[m] belong to sets[m].
+	// With qBits = 16 or 8, the scores are summed up from integer tables of that
+	// width, which are smaller and faster but approximate the log odds scores
+	static void calcLogOdds( std::vector<ScoreSeqSet*> sets,
+							 std::vector<float*> mops, std::vector<float*> zoops, size_t qBits = 0 );
+	// the largest difference of the scores from qBits quantized tables to the float scores
+	float quantizationError( size_t qBits );
+	// recompute the float scores at the given indices of a mops buffer of calcLogOdds
+	void rescoreLogOdds( float* mops, std::vector<size_t> indices );
+	// after scoring with quantized tables, recompute the float scores which the p-values
+	// of the hits depend on: all negative and positive scores which can reach the score
+	// threshold of pvalCutoff and the lowest negative scores, which define the tail
+	// of the p-values; the hits then get the p-values of a scan with float scores
+	static void rescoreQuantized( ScoreSeqSet* negSet, std::vector<float>& negScores,
+								  ScoreSeqSet* posSet, std::vector<float>& posScores,
+								  float pvalCutoff, size_t qBits );
+	// threshold scanning: only keep the positions scoring at least minScore, see getHitScores();
+	// a position is abandoned as soon as the best score reachable from its
+	// partial sum and the current (K)-mer context falls below minScore
+	void calcHits( float minScore );
+	// the same from the windows around the seeds of the motif in an index of the
+	// sequences: the q-mers which can reach minScore at the q columns where they
+	// occur least often; falls back to calcHits() if the seeds do not pay off
+	void calcSeededHits( float minScore, SeqIndex* index );
+	// the score below which no position can have a p-value below pvalCutoff
+	static float calcScoreThreshold( std::vector<float> neg_all_scores, float pvalCutoff );
+	// p-values for the given scores, i.e. of all positions or of the hits
 	void calcPvalues( std::vector<std::vector<float>> pos_mops_scores, std::vector<float> neg_all_scores );
+	// the same for negative scores which are already sorted in ascending order,
+	// e.g. null distributions which are kept for many scans
+	static float calcScoreThresholdSorted( const std::vector<float>& neg_all_scores, float pvalCutoff );
+	void calcPvaluesSorted( std::vector<std::vector<float>> pos_mops_scores,
+							const std::vector<float>& neg_all_scores );
 
 	std::vector<std::vector<float>> getMopsScores();
 	std::vector<float> 				getZoopsScores();
+	std::vector<std::vector<float>>	getHitScores();
 
-	void write( char* odir, std::string basename, float pvalCutoff, bool ss );
+	// format "occurrence", "bed" or "binary", see write()
+	void write( char* odir, std::string basename, float pvalCutoff, bool ss,
+				std::string format = "occurrence" );
+	// the same into a writer, e.g. of a socket
+	void write( RecordWriter& ofile, float pvalCutoff, bool ss, std::string format = "occurrence" );
     void writeLogOdds( char* odir, std::string basename, bool ss );
     void printLogOdds();
 
@@ -41,12 +101,50 @@ private:
 	Motif* 							motif_;
 	BackgroundModel* 				bg_;
 	std::vector<Sequence*>			seqSet_;
+	SeqSource*						seqSource_;	// NULL unless the sequences are generated on demand
+	size_t							stride_;
+	size_t							N_;			// number of scored sequences
+
+									// length, header and k-mers of the n-th scored sequence;
+									// generated sequences are written into the given buffers
+									// of seqSource_->getMaxL() entries, which then hold the letters
+	size_t							getL( size_t n );
+	std::string						getHeader( size_t n );
+	size_t*							getKmer( size_t n, uint8_t* seqBuf, size_t* kmerBuf );
+	uint8_t*						getSequence( size_t n, uint8_t* seqBuf );
+
+									// the threshold scan of calcHits() for compile-time order K and
+									// alphabet size A, see kmerKernel() in utils.h
+	template<size_t K, size_t A>
+	void							scanHits( float minScore, float bound, const float* s, const float* R,
+											  const float* sRC, const float* RRC );
+									// length of sequence n per strand, i.e. without reverse complement
+	size_t							getSeqLength( size_t n, bool ss );
+									// number of scored positions of sequence n on each strand
+	size_t							getLW1( size_t n, size_t W );
+									// write the occurrences as columnar table, see write()
+	void							writeColumns( RecordWriter& ofile, float pvalCutoff, bool ss );
+									// strand of position i of a sequence of seqlen letters per strand,
+									// and the start of its site on the forward strand
+	char							getSite( size_t seqlen, size_t LW1, size_t i, size_t& start );
+									// write strand, start..end and pattern of position i of sequence n
+	void							writeSite( RecordWriter& ofile, uint8_t* sequence, size_t seqlen,
+											   size_t LW1, size_t i );
+									// write the pattern of position i, on its strand
+	void							writePattern( RecordWriter& ofile, uint8_t* sequence, size_t seqlen,
+												  size_t LW1, size_t i );
 
     std::vector<float>				zoops_scores_;
 	std::vector<std::vector<float>>	mops_scores_;
     std::vector<std::vector<float>> mops_p_values_;
     std::vector<std::vector<float>> mops_e_values_;
+    std::vector<std::vector<float>> p_value_scores_;	// the scores of mops_p_values_, see setKeepScores()
     std::vector<size_t>             z_;
+    std::vector<std::vector<size_t>> hit_positions_;	// positions of the hits after calcHits()
+    std::vector<std::vector<float>> hit_scores_;
+    bool                            hits_only_;
+    bool                            revComp_;			// score the reverse strands, see setRevComp()
+    bool                            keep_scores_;
 
     bool                            pval_is_calulated_;
 	std::vector<size_t>				Y_;
@@ -0,0 +1,288 @@
+#ifdef OPENMP
+#include <omp.h>
+#endif
+
+#include "SeqIndex.h"
+
+SeqIndex::SeqIndex( std::vector<Sequence*> seqs, size_t q, char* storeDir ){
+
+	// the k-mer values of the sequences hold up to 11 letters
+	if( q < 1 or q > 11 ){
+		std::cerr << "Error: The q-mers of a sequence index have 1 to 11 letters." << std::endl;
+		exit( 1 );
+	}
+
+	q_ = q;
+	for( size_t k = 0; k <= q_; k++ ){
+		Y_.push_back( ipow( Alphabet::getSize(), k ) );
+	}
+
+	offsetsData_ = NULL;
+	positionsData_ = NULL;
+	mapped_ = NULL;
+	mappedSize_ = 0;
+
+	starts_.assign( 1, 0 );
+	for( size_t n = 0; n < seqs.size(); n++ ){
+		starts_.push_back( starts_.back() + seqs[n]->getL() );
+	}
+
+	// build the index, or read it from the store
+	if( storeDir != NULL ){
+		uint64_t hash = SequenceSet::hashSequences( seqs );
+		char name[48];
+		snprintf( name, sizeof( name ), "%016llx.q%zu.seqindex", ( unsigned long long )hash, q_ );
+		std::string filePath = std::string( storeDir ) + '/' + name;
+		if( !read( filePath, hash ) ){
+			build( seqs );
+			write( storeDir, filePath, hash );
+		}
+	} else {
+		build( seqs );
+	}
+}
+
+SeqIndex::~SeqIndex(){
+	if( mapped_ != NULL ){
+		munmap( mapped_, mappedSize_ );
+	}
+}
+
+// call f( x, p ) for the q-mers x with known letters at the start positions p of the
+// chunks c0, ..., c1-1 of the sequences, in the order of the positions
+template<typename F>
+static void visitQmers( std::vector<Sequence*>& seqs, const std::vector<uint64_t>& starts, size_t q, size_t Yq,
+						const std::vector<std::pair<size_t, size_t>>& chunks, size_t chunkSize,
+						size_t c0, size_t c1, F f ){
+	for( size_t c = c0; c < c1; c++ ){
+		size_t n = chunks[c].first;
+		size_t start = chunks[c].second;
+		uint8_t* sequence = seqs[n]->getSequence();
+		size_t* kmer = seqs[n]->getKmer();
+		size_t end = std::min( start + chunkSize, seqs[n]->getL() - q + 1 );
+		// the number of known letters up to the end of the current q-mer
+		size_t known = 0;
+		for( size_t p = start; p < start + q - 1; p++ ){
+			known = ( sequence[p] != 0 ) ? known + 1 : 0;
+		}
+		for( size_t s = start; s < end; s++ ){
+			known = ( sequence[s+q-1] != 0 ) ? known + 1 : 0;
+			if( known >= q ){
+				f( kmer[s+q-1] % Yq, starts[n] + s );
+			}
+		}
+	}
+}
+
+// sort the start positions by their q-mers, with per-thread counts over
+// consecutive chunks of positions, such that the positions stay ascending
+void SeqIndex::build( std::vector<Sequence*> seqs ){
+
+	size_t chunkSize = 1 << 16;
+	std::vector<std::pair<size_t, size_t>> chunks;
+	for( size_t n = 0; n < seqs.size(); n++ ){
+		for( size_t start = 0; start + q_ <= seqs[n]->getL(); start += chunkSize ){
+			chunks.push_back( std::make_pair( n, start ) );
+		}
+	}
+
+	size_t threads = 1;
+#ifdef OPENMP
+	threads = omp_get_max_threads();
+#endif
+	std::vector<std::vector<uint64_t>> counts( threads );
+
+#pragma omp parallel num_threads( threads )
+	{
+		size_t t = 0;
+#ifdef OPENMP
+		t = omp_get_thread_num();
+#endif
+		// each thread takes consecutive chunks
+		size_t c0 = t * chunks.size() / threads;
+		size_t c1 = ( t+1 ) * chunks.size() / threads;
+		counts[t].assign( Y_[q_], 0 );
+		uint64_t* count = counts[t].data();
+		visitQmers( seqs, starts_, q_, Y_[q_], chunks, chunkSize, c0, c1,
+					[count]( size_t x, uint64_t ){ count[x]++; } );
+
+#pragma omp barrier
+#pragma omp single
+		{
+			// the offsets of the q-mers, and of the positions of each thread within them
+			offsets_.assign( Y_[q_]+1, 0 );
+			for( size_t x = 0; x < Y_[q_]; x++ ){
+				offsets_[x+1] = offsets_[x];
+				for( size_t u = 0; u < threads; u++ ){
+					uint64_t c = counts[u][x];
+					counts[u][x] = offsets_[x+1];
+					offsets_[x+1] += c;
+				}
+			}
+			positions_.resize( offsets_[Y_[q_]] );
+		}
+
+		uint64_t* positions = positions_.data();
+		visitQmers( seqs, starts_, q_, Y_[q_], chunks, chunkSize, c0, c1,
+					[count, positions]( size_t x, uint64_t p ){ positions[count[x]++] = p; } );
+	}
+
+	// the ranges of start positions whose q-mers include unknown letters
+	unknown_.clear();
+	for( size_t n = 0; n < seqs.size(); n++ ){
+		uint8_t* sequence = seqs[n]->getSequence();
+		size_t L = seqs[n]->getL();
+		for( size_t p = 0; p < L; p++ ){
+			if( sequence[p] != 0 ){
+				continue;
+			}
+			uint64_t first = starts_[n] + ( ( p + 1 > q_ ) ? p + 1 - q_ : 0 );
+			uint64_t end = starts_[n] + std::min( p + 1, ( L >= q_ ) ? L - q_ + 1 : 0 );
+			if( first >= end ){
+				continue;
+			}
+			if( !unknown_.empty() and unknown_.back().second >= first ){
+				unknown_.back().second = end;
+			} else {
+				unknown_.push_back( std::make_pair( first, end ) );
+			}
+		}
+	}
+
+	offsetsData_ = offsets_.data();
+	positionsData_ = positions_.data();
+}
+
+size_t SeqIndex::getQ(){
+	return q_;
+}
+
+size_t SeqIndex::getN(){
+	return starts_.size() - 1;
+}
+
+uint64_t SeqIndex::getStart( size_t n ){
+	return starts_[n];
+}
+
+size_t SeqIndex::getSeq( uint64_t p ){
+	return std::upper_bound( starts_.begin(), starts_.end(), p ) - starts_.begin() - 1;
+}
+
+const uint64_t* SeqIndex::getPositions( size_t x, size_t& count ){
+	count = offsetsData_[x+1] - offsetsData_[x];
+	return positionsData_ + offsetsData_[x];
+}
+
+std::vector<std::pair<uint64_t, uint64_t>>& SeqIndex::getUnknown(){
+	return unknown_;
+}
+
+/**
+ * binary index store:
+ * "BaMMqix" and a format version byte
+ * uint64_t	hash of the sequence set
+ * uint64_t	alphabet size
+ * uint64_t	q
+ * uint64_t	number of sequences N
+ * uint64_t	number of positions
+ * uint64_t	number of ranges with unknown letters
+ * uint64_t	positions of the sequences, N+1
+ * uint64_t	offsets of the q-mers, alphabet size^q + 1
+ * uint64_t	positions
+ * uint64_t	first and end of the ranges with unknown letters
+ */
+static const char	indexStoreMagic[8] = { 'B', 'a', 'M', 'M', 'q', 'i', 'x', 1 };
+
+bool SeqIndex::read( std::string filePath, uint64_t hash ){
+
+	int fd = open( filePath.c_str(), O_RDONLY );
+	if( fd < 0 ){
+		return false;
+	}
+	struct stat sb;
+	size_t size = ( fstat( fd, &sb ) == 0 ) ? static_cast<size_t>( sb.st_size ) : 0;
+	void* mapped = ( size > 0 ) ? mmap( NULL, size, PROT_READ, MAP_PRIVATE, fd, 0 ) : MAP_FAILED;
+	close( fd );
+	if( mapped == MAP_FAILED ){
+		return false;
+	}
+	const char* data = static_cast<const char*>( mapped );
+	const uint64_t* words = reinterpret_cast<const uint64_t*>( data + 8 );
+	const uint64_t* offsets = NULL;
+
+	// the header sizes have to add up to the file size before any array is used
+	size_t N = getN();
+	size_t Yq = Y_[q_];
+	size_t headerSize = 8 + 6 * sizeof( uint64_t );
+	size_t fixedWords = 6 + ( N+1 ) + ( Yq+1 );
+	bool valid = ( size >= headerSize
+				   and memcmp( data, indexStoreMagic, 8 ) == 0
+				   and words[0] == hash and words[1] == Y_[1] and words[2] == q_ and words[3] == N
+				   and words[4] <= size / sizeof( uint64_t ) and words[5] <= size / ( 2 * sizeof( uint64_t ) )
+				   and 8 + ( fixedWords + words[4] + 2 * words[5] ) * sizeof( uint64_t ) == size );
+
+	// the offsets bound the positions of each q-mer within the file
+	if( valid ){
+		offsets = words + 6 + N+1;
+		valid = ( std::equal( starts_.begin(), starts_.end(), words + 6 )
+				  and offsets[0] == 0 and offsets[Yq] == words[4] );
+		for( size_t x = 0; valid and x < Yq; x++ ){
+			valid = ( offsets[x] <= offsets[x+1] );
+		}
+	}
+	if( !valid ){
+		munmap( mapped, size );
+		return false;
+	}
+
+	// the positions are only paged in as the q-mers are looked up
+	const uint64_t* positions = offsets + Yq+1;
+	const uint64_t* unknown = positions + words[4];
+	unknown_.resize( words[5] );
+	for( size_t r = 0; r < unknown_.size(); r++ ){
+		unknown_[r] = std::make_pair( unknown[2*r], unknown[2*r+1] );
+	}
+	offsets_.clear();
+	positions_.clear();
+	offsetsData_ = offsets;
+	positionsData_ = positions;
+	mapped_ = mapped;
+	mappedSize_ = size;
+
+	return true;
+}
+
+// the store only saves work: the run goes on with the built index if it cannot be written
+void SeqIndex::write( char* storeDir, std::string filePath, uint64_t hash ){
+
+	struct stat sb;
+	if( stat( storeDir, &sb ) != 0 ){
+		if( system( ( "mkdir -p " + std::string( storeDir ) ).c_str() ) != 0 ){
+			std::cerr << "Warning: Cannot create sequence index store: "
+					<< storeDir << std::endl;
+			return;
+		}
+	}
+
+	// write to a temporary file first, such that concurrent runs never read a partial store
+	std::string tmpPath = filePath + ".tmp" + std::to_string( getpid() );
+	FILE* file = fopen( tmpPath.c_str(), "wb" );
+
+	uint64_t header[6] = { hash, Y_[1], q_, getN(), positions_.size(), unknown_.size() };
+	bool written = ( file != NULL
+					 and fwrite( indexStoreMagic, 1, 8, file ) == 8
+					 and fwrite( header, sizeof( uint64_t ), 6, file ) == 6
+					 and fwrite( starts_.data(), sizeof( uint64_t ), starts_.size(), file ) == starts_.size()
+					 and fwrite( offsets_.data(), sizeof( uint64_t ), offsets_.size(), file ) == offsets_.size()
+					 and fwrite( positions_.data(), sizeof( uint64_t ), positions_.size(), file ) == positions_.size()
+					 and fwrite( unknown_.data(), 2 * sizeof( uint64_t ), unknown_.size(), file ) == unknown_.size() );
+	if( file != NULL and fclose( file ) != 0 ){
+		written = false;
+	}
+	if( !written or rename( tmpPath.c_str(), filePath.c_str() ) != 0 ){
+		std::cerr << "Warning: Cannot write sequence index store: "
+				<< filePath << std::endl;
+		remove( tmpPath.c_str() );
+	}
+}
@@ -0,0 +1,61 @@
+#ifndef SEQINDEX_H_
+#define SEQINDEX_H_
+
+#include <string>
+#include <vector>
+
+#include <stdint.h>	// e.g. uint64_t
+#include <stdio.h>	// e.g. fopen
+#include <fcntl.h>	// e.g. open
+#include <sys/mman.h>	// e.g. mmap
+#include <sys/stat.h>	// e.g. fstat
+#include <unistd.h>	// e.g. getpid
+
+#include "../init/SequenceSet.h"
+
+class SeqIndex{
+
+	/*
+	 * An index of the q-mers of a sequence set, e.g. for seeding motif scans:
+	 * the start positions of each q-mer in the concatenation of the sequences.
+	 * Start positions whose q letters include unknown letters are kept as ranges,
+	 * since the k-mer values of unknown letters are drawn at random. The index
+	 * is built once per sequence set and q and reused from the store directory,
+	 * whose offsets and positions are mapped into memory rather than read.
+	 */
+
+public:
+
+	SeqIndex( std::vector<Sequence*> seqs, size_t q, char* storeDir = NULL );
+	~SeqIndex();
+
+	size_t			getQ();
+	size_t			getN();							// number of sequences
+	uint64_t		getStart( size_t n );			// position of sequence n in the concatenation
+	size_t			getSeq( uint64_t p );			// the sequence of position p
+
+					// the start positions of the q-mer x, ascending: count of them from first
+	const uint64_t*	getPositions( size_t x, size_t& count );
+					// ranges [first, end) of start positions with unknown letters
+	std::vector<std::pair<uint64_t, uint64_t>>&	getUnknown();
+
+private:
+
+	void			build( std::vector<Sequence*> seqs );
+	bool			read( std::string filePath, uint64_t hash );
+	void			write( char* storeDir, std::string filePath, uint64_t hash );
+
+	size_t					q_;
+	std::vector<uint64_t>	starts_;			// positions of the sequences, and their total length
+	std::vector<uint64_t>	offsets_;			// first entry of each q-mer in positions_
+	std::vector<uint64_t>	positions_;
+	std::vector<std::pair<uint64_t, uint64_t>>	unknown_;
+	std::vector<size_t>		Y_;
+
+	const uint64_t*			offsetsData_;		// offsets_, or those of the mapped store
+	const uint64_t*			positionsData_;		// positions_, or those of the mapped store
+	void*					mapped_;			// the mapped store, if read from it
+	size_t					mappedSize_;
+};
+
+#endif /* SEQINDEX_H_ */
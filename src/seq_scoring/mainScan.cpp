@@ -5,8 +5,10 @@
 
 #include "GScan.h"
 #include "ScoreSeqSet.h"
+#include "ScanServer.h"
 #include "../init/MotifSet.h"
 #include "../seq_generator/SeqGenerator.h"
+#include "../seq_generator/BgSeqSource.h"
 
 int main( int nargs, char* args[] ) {
 
@@ -19,13 +21,7 @@ int main( int nargs, char* args[] ) {
     /**
      * Build up the background model
      */
-    // use bgModel generated from input sequences when prediction is turned on
-    BackgroundModel* bgModel = new BackgroundModel( GScan::negSequenceSet->getSequences(),
-                                       GScan::bgModelOrder,
-                                       GScan::bgModelAlpha,
-                                       GScan::interpolateBG,
-                                       GScan::outputFileBasename );
-
+    BackgroundModel* bgModel;
     // use provided bgModelFile if initialized with bamm format
     if( GScan::initialModelTag == "BaMM" ) {
         if( GScan::bgModelFilename == NULL ) {
@@ -34,9 +30,20 @@ int main( int nargs, char* args[] ) {
         }
         // get background model from the given file
         bgModel = new BackgroundModel( GScan::bgModelFilename );
-    } else if( GScan::initialModelTag == "PWM" ){
-        // this means that also the global motif order needs to be adjusted;
-        GScan::modelOrder = 0;
+    } else {
+        // use bgModel generated from input sequences when prediction is turned on
+        bgModel = new BackgroundModel( GScan::negSequenceSet->getSequences(),
+                                       GScan::bgModelOrder,
+                                       GScan::bgModelAlpha,
+                                       GScan::interpolateBG,
+                                       GScan::outputFileBasename,
+                                       GScan::bgModelStore,
+                                       GScan::negSequenceSet->getHash(),
+                                       GScan::revCompTable );
+        if( GScan::initialModelTag == "PWM" ){
+            // this means that also the global motif order needs to be adjusted;
+            GScan::modelOrder = 0;
+        }
     }
 
     if(GScan::saveInitialModel){
@@ -72,69 +79,197 @@ int main( int nargs, char* args[] ) {
         }
     }
 
+    /**
+     * Index the q-mers of the positive sequences once for seeding all motif scans
+     */
+    SeqIndex* seqIndex = NULL;
+    if( GScan::seedIndex != NULL ){
+        seqIndex = new SeqIndex( posSet, GScan::seedLength, GScan::seedIndex );
+    }
+
     /**
      * Sample negative sequence set based on s-mer frequencies
      */
-    std::vector<Sequence*>  negset;
     size_t minSeqN = 5000;
     // sample negative sequence set B1set based on s-mer frequencies
-    // from positive training sequence set
-    std::vector<std::unique_ptr<Sequence>> negSeqs;
+    // from positive training sequence set; the sequences are only
+    // generated when they are scored
     SeqGenerator negseq( posSet );
+    BgSeqSource* negSource;
     if( posSet.size() >= minSeqN ){
-        negSeqs = negseq.sample_bgseqset_by_fold( GScan::mFold );
+        negSource = new BgSeqSource( &negseq, GScan::mFold );
     } else {
-        negSeqs = negseq.sample_bgseqset_by_num( minSeqN, GScan::posSequenceSet->getMaxL() );
+        negSource = new BgSeqSource( &negseq, minSeqN, GScan::posSequenceSet->getMaxL() );
     }
-    // convert unique_ptr to regular pointer
-    for( size_t n = 0; n < negSeqs.size(); n++ ) {
-        negset.push_back( negSeqs[n].release() );
-        negSeqs[n].get_deleter();
+
+    /**
+     * Score the motifs in batches: the negative and positive sequences are
+     * streamed once per batch and scored with all its motifs, the batches
+     * are limited by the memory of the negative and positive scores; a
+     * threshold scan scores the positive sequences of each motif separately
+     * and only keeps the positions which can reach the p-value cutoff
+     */
+    size_t negL = 0;
+    for( size_t i = 0; i < negSource->getN(); i++ ){
+        negL += negSource->getL( i );
+    }
+    size_t posL = 0;
+    if( !GScan::thresholdScan ){
+        for( size_t i = 0; i < posSet.size(); i++ ){
+            posL += posSet[i]->getL();
+        }
     }
+    size_t maxScoreBytes = size_t( 1 ) << 30;
+    size_t batchSize = std::max( size_t( 1 ), maxScoreBytes / ( ( negL + posL ) * sizeof( float ) + 1 ) );
 
-#pragma omp parallel for
-    for( size_t n = 0; n < motif_set.getN(); n++ ) {
-        // deep copy each motif in the motif set
-        Motif *motif = new Motif( *motif_set.getMotifs()[n] );
+    /**
+     * Serve scan requests: the negative scores of each motif are computed and
+     * sorted once, as null distributions of the scans of the requests
+     */
+    if( GScan::serve != NULL ){
 
-        std::string fileExtension;
-        if( GScan::initialModelTag == "PWM" ){
-            fileExtension = "_motif_" + std::to_string( n+1 );
+        std::vector<Motif*> motifs( motif_set.getN() );
+        std::vector<std::string> names( motif_set.getN() );
+        std::vector<std::vector<float>> nullScores( motif_set.getN() );
+
+        for( size_t first = 0; first < motif_set.getN(); first += batchSize ){
+
+            size_t B = std::min( batchSize, motif_set.getN() - first );
+
+            std::vector<ScoreSeqSet*> negSets( B );
+            std::vector<float*> negMops( B );
+            for( size_t b = 0; b < B; b++ ){
+                size_t n = first + b;
+                motifs[n] = new Motif( *motif_set.getMotifs()[n] );
+                names[n] = "motif_" + std::to_string( n+1 );
+                negSets[b] = new ScoreSeqSet( motifs[n], bgModel, negSource );
+                negSets[b]->setRevComp( GScan::revCompTable );
+                size_t negAllN = 0;
+                for( size_t i = 0; i < negSource->getN(); i++ ){
+                    negAllN += negSets[b]->getPositions( i, motifs[n]->getW() );
+                }
+                nullScores[n].resize( negAllN );
+                negMops[b] = nullScores[n].data();
+            }
+
+            ScoreSeqSet::calcLogOdds( negSets, negMops, std::vector<float*>( B, NULL ) );
+
+            for( size_t b = 0; b < B; b++ ){
+                parallelSort( nullScores[first+b], std::less<float>() );
+                delete negSets[b];
+            }
         }
 
-        if( GScan::saveInitialModel ){
-            // write out the foreground model
-            motif->write( GScan::outputDirectory,
-                          GScan::outputFileBasename + fileExtension );
+        ScanServer server( motifs, names, bgModel, std::move( nullScores ),
+                           GScan::ss, GScan::revCompTable, GScan::pvalCutoff,
+                           GScan::maxRequestMB << 20 );
+        server.serve( GScan::serve, GScan::threads );
+
+        for( size_t n = 0; n < motifs.size(); n++ ){
+            delete motifs[n];
         }
+        delete negSource;
+        delete bgModel;
+        GScan::destruct();
 
-        // score negative sequence set
-        ScoreSeqSet scoreNegSet( motif, bgModel, negset );
-        scoreNegSet.calcLogOdds();
-        std::vector<std::vector<float>> negAllScores = scoreNegSet.getMopsScores();
-        std::vector<float> negScores;
-        for( size_t n = 0; n < negset.size(); n++ ){
-            negScores.insert( std::end( negScores ),
-                              std::begin( negAllScores[n] ),
-                              std::end( negAllScores[n] ) );
+        return 0;
+    }
+
+    for( size_t first = 0; first < motif_set.getN(); first += batchSize ) {
+
+        size_t B = std::min( batchSize, motif_set.getN() - first );
+
+        std::vector<Motif*> motifs( B );
+        std::vector<ScoreSeqSet*> negSets( B ), posSets( B );
+        std::vector<std::vector<float>> negScores( B ), posScores( B );
+        std::vector<float*> negMops( B ), posMops( B );
+        for( size_t b = 0; b < B; b++ ){
+            // deep copy each motif in the motif set
+            motifs[b] = new Motif( *motif_set.getMotifs()[first+b] );
+            negSets[b] = new ScoreSeqSet( motifs[b], bgModel, negSource );
+            posSets[b] = new ScoreSeqSet( motifs[b], bgModel, posSet );
+            negSets[b]->setRevComp( GScan::revCompTable );
+            posSets[b]->setRevComp( GScan::revCompTable );
+            posSets[b]->setKeepScores( GScan::outputFormat == "binary" );
+            size_t W = motifs[b]->getW();
+            size_t negAllN = 0;
+            for( size_t i = 0; i < negSource->getN(); i++ ){
+                negAllN += negSets[b]->getPositions( i, W );
+            }
+            size_t posAllN = 0;
+            if( !GScan::thresholdScan ){
+                for( size_t i = 0; i < posSet.size(); i++ ){
+                    posAllN += posSets[b]->getPositions( i, W );
+                }
+            }
+            negScores[b].resize( negAllN );
+            posScores[b].resize( posAllN );
+            negMops[b] = negScores[b].data();
+            posMops[b] = posScores[b].data();
+        }
+
+        // score negative and positive sequence sets
+        ScoreSeqSet::calcLogOdds( negSets, negMops, std::vector<float*>( B, NULL ), GScan::quantize );
+        if( !GScan::thresholdScan ){
+            ScoreSeqSet::calcLogOdds( posSets, posMops, std::vector<float*>( B, NULL ), GScan::quantize );
         }
 
-        // score positive sequence set
-        // calculate p-values based on positive and negative scores
-        ScoreSeqSet scorePosSet( motif, bgModel, posSet );
-        scorePosSet.calcLogOdds();
+#pragma omp parallel for schedule(dynamic) if( B > 1 )
+        for( size_t b = 0; b < B; b++ ) {
 
-        std::vector<std::vector<float>> posScores = scorePosSet.getMopsScores();
-        scorePosSet.calcPvalues( posScores, negScores );
+            size_t n = first + b;
+            Motif* motif = motifs[b];
 
-        scorePosSet.write( GScan::outputDirectory,
-                           GScan::outputFileBasename + fileExtension,
-                           GScan::pvalCutoff,
-                           GScan::ss );
+            std::string fileExtension;
+            if( GScan::initialModelTag == "PWM" or motif_set.getN() > 1 ){
+                fileExtension = "_motif_" + std::to_string( n+1 );
+            }
 
-        delete motif;
+            if( GScan::saveInitialModel ){
+                // write out the foreground model
+                motif->write( GScan::outputDirectory,
+                              GScan::outputFileBasename + fileExtension );
+            }
+
+            // calculate p-values based on positive and negative scores
+            std::vector<std::vector<float>> posSeqScores( posSet.size() );
+            if( GScan::thresholdScan ){
+                float minScore = ScoreSeqSet::calcScoreThreshold( negScores[b], GScan::pvalCutoff );
+                if( seqIndex != NULL ){
+                    posSets[b]->calcSeededHits( minScore, seqIndex );
+                } else {
+                    posSets[b]->calcHits( minScore );
+                }
+                posSeqScores = posSets[b]->getHitScores();
+            } else {
+                if( GScan::quantize ){
+                    ScoreSeqSet::rescoreQuantized( negSets[b], negScores[b], posSets[b], posScores[b],
+                                                   GScan::pvalCutoff, GScan::quantize );
+                }
+                size_t LW1;
+                for( size_t i = 0, offset = 0; i < posSet.size(); i++, offset += LW1 ){
+                    LW1 = posSets[b]->getPositions( i, motif->getW() );
+                    posSeqScores[i].assign( posScores[b].begin() + offset,
+                                            posScores[b].begin() + offset + LW1 );
+                }
+                std::vector<float>().swap( posScores[b] );
+            }
+            posSets[b]->calcPvalues( std::move( posSeqScores ), std::move( negScores[b] ) );
+
+            posSets[b]->write( GScan::outputDirectory,
+                               GScan::outputFileBasename + fileExtension,
+                               GScan::pvalCutoff,
+                               GScan::ss,
+                               GScan::outputFormat );
+
+            delete negSets[b];
+            delete posSets[b];
+            delete motif;
+        }
     }
 
+    delete negSource;
+    if( seqIndex ) delete seqIndex;
     if( bgModel ) delete bgModel;
     GScan::destruct();
 
@@ -0,0 +1,49 @@
+#ifndef PLAINSCORES_H_
+#define PLAINSCORES_H_
+
+#include <float.h>		// -FLT_MAX
+
+#include "../src/init/BackgroundModel.h"
+#include "../src/init/Motif.h"
+#include "../src/init/Sequence.h"
+
+// the log odds scores of all positions of the sequences, summed up window by
+// window as by the original scorer: the reference of the tiled, quantized,
+// reverse-complement and threshold scorers
+inline std::vector<std::vector<float>> plainLogOdds( Motif* motif, BackgroundModel* bg,
+													 std::vector<Sequence*> seqs ){
+
+	size_t K = motif->getK();
+	size_t W = motif->getW();
+	size_t K_bg = ( bg->getOrder() < K ) ? bg->getOrder() : K;
+	motif->calculateLogS( bg->getV(), K_bg );
+	float** s = motif->getS();
+	size_t YK1 = motif->getY()[K+1];
+
+	std::vector<std::vector<float>> scores( seqs.size() );
+	for( size_t n = 0; n < seqs.size(); n++ ){
+		size_t L = seqs[n]->getL();
+		size_t* kmer = seqs[n]->getKmer();
+		for( size_t i = 0; i + W <= L; i++ ){
+			float logOdds = 0.0f;
+			for( size_t j = 0; j < W; j++ ){
+				logOdds += s[kmer[i+j] % YK1][j];
+			}
+			scores[n].push_back( logOdds );
+		}
+	}
+	return scores;
+}
+
+// the largest score of each sequence
+inline std::vector<float> plainZoops( const std::vector<std::vector<float>>& scores ){
+	std::vector<float> zoops( scores.size(), -FLT_MAX );
+	for( size_t n = 0; n < scores.size(); n++ ){
+		for( size_t i = 0; i < scores[n].size(); i++ ){
+			zoops[n] = std::max( zoops[n], scores[n][i] );
+		}
+	}
+	return zoops;
+}
+
+#endif /* PLAINSCORES_H_ */
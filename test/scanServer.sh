@@ -0,0 +1,68 @@
+#!/bin/bash
+# smoke test of BaMMScan --serve with py/bammscan_client.py:
+#   scanServer.sh BaMMScan SOURCE_DIR PYTHON
+# a scan request is answered, equal requests get equal replies, invalid p-value
+# cutoffs and oversized requests are rejected, and #shutdown stops the server
+
+BaMMScan=$1
+SRC=$2
+PYTHON=$3
+
+DIR=$( mktemp -d )
+trap 'kill $PID 2> /dev/null; rm -rf $DIR' EXIT
+
+fail(){
+	echo "FAIL: $1"
+	cat $DIR/log
+	exit 1
+}
+
+$BaMMScan $DIR $SRC/example/JunD.fasta --BaMMFile $SRC/example/JunD_motif_1.ihbcp \
+	--bgModelFile $SRC/example/JunD.hbcp --serve $DIR/socket --maxRequestMB 1 > $DIR/log 2>&1 &
+PID=$!
+
+for i in $( seq 100 ); do
+	[ -S $DIR/socket ] && break
+	kill -0 $PID 2> /dev/null || fail "the server did not start"
+	sleep 0.1
+done
+[ -S $DIR/socket ] || fail "the server did not open its socket"
+
+client(){
+	$PYTHON $SRC/py/bammscan_client.py $DIR/socket "$@"
+}
+
+client $SRC/example/JunD.fasta -o $DIR/reply || fail "the scan request failed"
+[ "$( head -n 2 $DIR/reply )" == $'# motif_1\nseq\tlength\tstrand\tstart..end\tpattern\tp-value\te-value' ] \
+	|| fail "the reply does not start with the motif and the header line"
+[ $( wc -l < $DIR/reply ) -gt 100 ] || fail "the reply holds too few occurrences"
+
+client $SRC/example/JunD.fasta --pvalCutoff 1e-6 -o $DIR/strict || fail "the request with a cutoff failed"
+[ $( wc -l < $DIR/strict ) -lt $( wc -l < $DIR/reply ) ] || fail "the p-value cutoff is not applied"
+
+# unknown letters are drawn anew for each request
+sed '/^>/!s/[ACGT]\{4\}$/NNNN/' $SRC/example/JunD.fasta > $DIR/unknown.fasta
+client $DIR/unknown.fasta -o $DIR/unknown1 || fail "the request with unknown letters failed"
+client $DIR/unknown.fasta -o $DIR/unknown2 || fail "the request with unknown letters failed"
+cmp -s $DIR/unknown1 $DIR/unknown2 || fail "equal requests get different replies"
+
+for i in $( seq 20 ); do cat $SRC/example/JunD.fasta; done > $DIR/large.fasta
+client $DIR/large.fasta > /dev/null 2> $DIR/error && fail "the oversized request is accepted"
+grep -q "The request exceeds 1048576 bytes" $DIR/error || fail "no error reply for the oversized request"
+
+for cutoff in nan inf -0.1 2; do
+	client $SRC/example/JunD.fasta --pvalCutoff $cutoff > /dev/null 2> $DIR/error \
+		&& fail "the p-value cutoff $cutoff is accepted"
+	grep -q "#pvalCutoff takes a number from 0 to 1" $DIR/error || fail "no error reply for the cutoff $cutoff"
+done
+
+client --shutdown > /dev/null || fail "the shutdown request failed"
+for i in $( seq 100 ); do
+	kill -0 $PID 2> /dev/null || break
+	sleep 0.1
+done
+kill -0 $PID 2> /dev/null && fail "#shutdown did not stop the server"
+wait $PID || fail "the server did not exit cleanly"
+[ -e $DIR/socket ] && fail "the socket is left behind"
+
+exit 0
@@ -0,0 +1,84 @@
+/*
+ * models written to a binary BaMM file (.ihbb) read back with the same
+ * parameters and scores as from the text BaMM file, also with added flanks;
+ * without flanks the stored probabilities are used as they are
+ */
+
+#include "testUtils.h"
+
+#include "../src/init/MotifSet.h"
+
+// the same W, K, q, alphas, conditional probabilities, probabilities and log odds scores
+static bool equalMotifs( Motif* a, Motif* b, float** v_bg, size_t k_bg ){
+
+	if( a->getW() != b->getW() or a->getK() != b->getK() or a->getQ() != b->getQ() ){
+		return false;
+	}
+	size_t W = a->getW();
+	std::vector<size_t> Y = a->getY();
+	for( size_t k = 0; k <= a->getK(); k++ ){
+		for( size_t j = 0; j < W; j++ ){
+			if( a->getA()[k][j] != b->getA()[k][j] ){
+				return false;
+			}
+			for( size_t y = 0; y < Y[k+1]; y++ ){
+				if( a->getV()[k][y][j] != b->getV()[k][y][j] or a->getP()[k][y][j] != b->getP()[k][y][j] ){
+					return false;
+				}
+			}
+		}
+	}
+	a->calculateLogS( v_bg, k_bg );
+	b->calculateLogS( v_bg, k_bg );
+	for( size_t y = 0; y < Y[a->getK()+1]; y++ ){
+		for( size_t j = 0; j < W; j++ ){
+			if( a->getS()[y][j] != b->getS()[y][j] ){
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+int main( int nargs, char* args[] ){
+
+	std::string example = initTest( nargs, args );
+	std::string dir = tempDirectory();
+
+	BackgroundModel bg( example + "/JunD.hbcp" );
+	float** v_bg = bg.getV();
+	size_t k_bg = bg.getOrder();
+
+	// the models of order 2 with the default alphas of BaMMScan
+	size_t order = 2;
+	std::vector<float> alphas( order+1, 1.0f );
+
+	std::string textPath = example + "/JunD_motif_1.ihbcp";
+	MotifSet text( const_cast<char*>( textPath.c_str() ), 0, 0, "BaMM", NULL, v_bg, k_bg, order, alphas );
+	CHECK( !Motif::isBinary( textPath.c_str() ) );
+
+	// a library of two models
+	std::string binaryPath = dir + "/library.ihbb";
+	Motif* motif = text.getMotifs()[0];
+	std::vector<std::string> names = { "JunD_motif_1", "copy" };
+	Motif::writeBinary( std::vector<Motif*>( 2, motif ), names, binaryPath );
+	CHECK( Motif::isBinary( binaryPath.c_str() ) );
+
+	MotifSet binary( const_cast<char*>( binaryPath.c_str() ), 0, 0, "BaMM", NULL, v_bg, k_bg,
+						  order, alphas );
+	CHECK( binary.getN() == 2 );
+	for( size_t i = 0; i < binary.getN(); i++ ){
+		CHECK( equalMotifs( motif, binary.getMotifs()[i], v_bg, k_bg ) );
+	}
+
+	// flanks are added to the models as to the text models
+	MotifSet textFlanks( const_cast<char*>( textPath.c_str() ), 2, 1, "BaMM", NULL, v_bg, k_bg,
+						  order, alphas );
+	MotifSet binaryFlanks( const_cast<char*>( binaryPath.c_str() ), 2, 1, "BaMM", NULL, v_bg, k_bg,
+						  order, alphas );
+	CHECK( binaryFlanks.getMotifs()[0]->getW() == motif->getW() + 3 );
+	CHECK( equalMotifs( textFlanks.getMotifs()[0], binaryFlanks.getMotifs()[0], v_bg, k_bg ) );
+
+	removeDirectory( dir );
+	return finishTest();
+}
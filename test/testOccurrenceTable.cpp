@@ -0,0 +1,139 @@
+/*
+ * the columnar occurrence table (.occurrence.bin) holds the headers and the
+ * occurrences of the text output, with the scores given to calcPvalues(), for
+ * the scores of all positions and for the hits of a threshold scan
+ */
+
+#include <iomanip>
+#include <sstream>
+
+#include "testUtils.h"
+#include "plainScores.h"
+
+#include "../src/init/MotifSet.h"
+#include "../src/seq_scoring/ScoreSeqSet.h"
+
+// the tab-separated fields of the lines of a text file, without its header line
+static std::vector<std::vector<std::string>> readLines( std::string filePath ){
+	std::vector<char> data = readFile( filePath );
+	std::istringstream text( std::string( data.begin(), data.end() ) );
+	std::vector<std::vector<std::string>> lines;
+	std::string line;
+	std::getline( text, line );
+	while( std::getline( text, line ) ){
+		std::vector<std::string> fields;
+		std::istringstream fieldStream( line );
+		std::string field;
+		while( std::getline( fieldStream, field, '\t' ) ){
+			fields.push_back( field );
+		}
+		lines.push_back( fields );
+	}
+	return lines;
+}
+
+// a value as written to the text output
+static std::string formatted( float value ){
+	std::ostringstream out;
+	out << std::setprecision( 3 ) << value;
+	return out.str();
+}
+
+int main( int nargs, char* args[] ){
+
+	std::string example = initTest( nargs, args );
+	std::string dir = tempDirectory();
+
+	SequenceSet sequenceSet( example + "/JunD.fasta", false );
+	std::vector<Sequence*> seqs = sequenceSet.getSequences();
+	BackgroundModel bg( example + "/JunD.hbcp" );
+
+	std::string bammPath = example + "/JunD_motif_1.ihbcp";
+	MotifSet bamm( const_cast<char*>( bammPath.c_str() ), 0, 0, "BaMM", NULL, bg.getV(), bg.getOrder(),
+				   2, std::vector<float>( 3, 1.0f ) );
+	Motif* motif = bamm.getMotifs()[0];
+	size_t W = motif->getW();
+	std::vector<std::vector<float>> expected = plainLogOdds( motif, &bg, seqs );
+	std::vector<float> negScores;
+	for( size_t n = 0; n < expected.size(); n++ ){
+		negScores.insert( negScores.end(), expected[n].begin(), expected[n].end() );
+	}
+	std::vector<float> sorted( negScores );
+	std::sort( sorted.begin(), sorted.end() );
+
+	float pvalCutoff = 1e-3f;
+	for( size_t hitsOnly = 0; hitsOnly < 2; hitsOnly++ ){
+
+		ScoreSeqSet set( motif, &bg, seqs );
+		set.setKeepScores( true );
+		if( hitsOnly ){
+			set.calcHits( sorted[( size_t )( 0.99f * sorted.size() )] );
+			set.calcPvalues( set.getHitScores(), negScores );
+		} else {
+			set.calcLogOdds();
+			set.calcPvalues( set.getMopsScores(), negScores );
+		}
+		std::string basename = "JunD" + std::to_string( hitsOnly );
+		set.write( const_cast<char*>( dir.c_str() ), basename, pvalCutoff, false, "occurrence" );
+		set.write( const_cast<char*>( dir.c_str() ), basename, pvalCutoff, false, "binary" );
+
+		std::vector<std::vector<std::string>> lines = readLines( dir + '/' + basename + ".occurrence" );
+		std::vector<char> data = readFile( dir + '/' + basename + ".occurrence.bin" );
+		CHECK( lines.size() > 10 );
+		CHECK( data.size() >= 32 );
+		if( data.size() < 32 ){
+			continue;
+		}
+		CHECK( std::string( data.data(), 7 ) == "BaMMocc" and data[7] == 2 );
+		CHECK( valueAt<uint64_t>( data, 8 ) == W );
+		uint64_t N = valueAt<uint64_t>( data, 16 );
+		uint64_t R = valueAt<uint64_t>( data, 24 );
+		CHECK( N == seqs.size() );
+		CHECK( R == lines.size() );
+
+		// the headers, padded to 8 bytes
+		size_t offset = 32;
+		std::vector<uint64_t> offsets( N+1 );
+		for( size_t n = 0; n <= N; n++, offset += sizeof( uint64_t ) ){
+			offsets[n] = valueAt<uint64_t>( data, offset );
+		}
+		CHECK( offsets[0] == 0 and std::is_sorted( offsets.begin(), offsets.end() ) );
+		std::string letters( data.data() + offset, offsets[N] );
+		offset += ( offsets[N] + 7 ) / 8 * 8;
+
+		// the columns, each of R values
+		CHECK( data.size() == offset + R * ( 5 * 4 + 1 ) );
+		if( data.size() != offset + R * ( 5 * 4 + 1 ) or R != lines.size() ){
+			continue;
+		}
+		size_t mismatches = 0;
+		for( size_t r = 0; r < R; r++ ){
+			uint32_t n = valueAt<uint32_t>( data, offset + r * 4 );
+			uint32_t start = valueAt<uint32_t>( data, offset + ( R + r ) * 4 );
+			float score = valueAt<float>( data, offset + ( 2 * R + r ) * 4 );
+			float pValue = valueAt<float>( data, offset + ( 3 * R + r ) * 4 );
+			float eValue = valueAt<float>( data, offset + ( 4 * R + r ) * 4 );
+			char strand = data[offset + 5 * R * 4 + r];
+			if( n >= N or lines[r].size() < 7 ){
+				mismatches++;
+				continue;
+			}
+
+			// the text output reports the reverse strand at its position in the
+			// sequence with its reverse complement appended
+			size_t seqlen = std::stoul( lines[r][1] );
+			size_t i = ( strand == '+' ) ? start : 2 * seqlen + 1 - W - start;
+			std::string header = letters.substr( offsets[n], offsets[n+1] - offsets[n] );
+			mismatches += ( header != lines[r][0] )
+						  or ( std::string( 1, strand ) != lines[r][2] )
+						  or ( std::to_string( i + 1 ) + ".." + std::to_string( i + W ) != lines[r][3] )
+						  or ( i >= expected[n].size() or score != expected[n][i] )
+						  or ( formatted( pValue ) != lines[r][5] )
+						  or ( formatted( eValue ) != lines[r][6] );
+		}
+		CHECK( mismatches == 0 );
+	}
+
+	removeDirectory( dir );
+	return finishTest();
+}
@@ -0,0 +1,95 @@
+/*
+ * the binary positional likelihoods (.lhb) in the formats float32, float16
+ * and dict hold the likelihoods v[k][y] of all positions of all sequences
+ */
+
+#include "testUtils.h"
+
+#include "../src/init/BackgroundModel.h"
+#include "../src/init/SequenceSet.h"
+
+int main( int nargs, char* args[] ){
+
+	std::string example = initTest( nargs, args );
+	std::string dir = tempDirectory();
+
+	SequenceSet sequenceSet( example + "/JunD.fasta", false );
+	std::vector<Sequence*> seqs = sequenceSet.getSequences();
+	BackgroundModel bg( example + "/JunD.hbcp" );
+	size_t K = bg.getOrder();
+
+	std::vector<size_t> Y;
+	for( size_t k = 0; k <= K+1; k++ ){
+		Y.push_back( ipow( Alphabet::getSize(), k ) );
+	}
+
+	const char* formats[] = { "float32", "float16", "dict" };
+	for( size_t type = 0; type < 3; type++ ){
+
+		bg.calculatePosLikelihoods( seqs, const_cast<char*>( dir.c_str() ), formats[type] );
+		float** v = bg.getV();
+
+		std::vector<char> data = readFile( dir + "/JunD_.lhb" );
+		CHECK( data.size() >= 32 );
+		if( data.size() < 32 ){
+			continue;
+		}
+		CHECK( std::string( data.data(), 7 ) == "BaMMlhb" and data[7] == 1 );
+		CHECK( valueAt<uint32_t>( data, 8 ) == type );
+		uint32_t bytes = valueAt<uint32_t>( data, 12 );
+		uint64_t N = valueAt<uint64_t>( data, 16 );
+		uint64_t D = valueAt<uint64_t>( data, 24 );
+		CHECK( N == seqs.size() );
+
+		// the dictionary holds v[k][y] for k = 0, ..., K
+		size_t offset = 32;
+		std::vector<float> dict;
+		for( size_t d = 0; d < D; d++, offset += sizeof( float ) ){
+			dict.push_back( valueAt<float>( data, offset ) );
+		}
+		if( type == 2 ){
+			CHECK( D == ( Y[K+1] * Alphabet::getSize() - 1 ) / ( Alphabet::getSize() - 1 ) - 1 );
+		}
+		std::vector<size_t> first( K+1, 0 );
+		for( size_t k = 1; k <= K; k++ ){
+			first[k] = first[k-1] + Y[k];
+		}
+
+		std::vector<uint64_t> offsets( N+1 );
+		for( size_t n = 0; n <= N; n++, offset += sizeof( uint64_t ) ){
+			offsets[n] = valueAt<uint64_t>( data, offset );
+		}
+		CHECK( data.size() == offset + offsets[N] * bytes );
+		if( data.size() != offset + offsets[N] * bytes ){
+			continue;
+		}
+
+		size_t mismatches = 0;
+		for( size_t n = 0; n < N; n++ ){
+			size_t L = seqs[n]->getL();
+			size_t* kmer = seqs[n]->getKmer();
+			CHECK( offsets[n+1] - offsets[n] == L );
+			for( size_t i = 0; i < L; i++ ){
+				size_t k = std::min( i, K );
+				size_t y = kmer[i] % Y[k+1];
+				size_t at = offset + ( offsets[n] + i ) * bytes;
+				bool equal;
+				if( type == 0 ){
+					equal = ( valueAt<float>( data, at ) == v[k][y] );
+				} else if( type == 1 ){
+					equal = ( valueAt<uint16_t>( data, at ) == floatToHalf( v[k][y] ) );
+				} else {
+					uint32_t index = ( bytes == 1 ) ? valueAt<uint8_t>( data, at )
+									 : ( bytes == 2 ) ? valueAt<uint16_t>( data, at )
+									 : valueAt<uint32_t>( data, at );
+					equal = ( index == first[k] + y and dict[index] == v[k][y] );
+				}
+				mismatches += !equal;
+			}
+		}
+		CHECK( mismatches == 0 );
+	}
+
+	removeDirectory( dir );
+	return finishTest();
+}
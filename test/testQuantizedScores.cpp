@@ -0,0 +1,117 @@
+/*
+ * quantized score tables give scores within quantizationError() of the plain
+ * scores, and after rescoreQuantized() the same occurrences and p-values as
+ * the float scores
+ */
+
+#include "testUtils.h"
+#include "plainScores.h"
+
+#include "../src/init/MotifSet.h"
+#include "../src/seq_scoring/ScoreSeqSet.h"
+
+// the flat scores of a set, quantized to qBits
+static std::vector<float> flatScores( ScoreSeqSet* set, size_t W, size_t N, size_t qBits ){
+	size_t positions = 0;
+	for( size_t n = 0; n < N; n++ ){
+		positions += set->getPositions( n, W );
+	}
+	std::vector<float> scores( positions );
+	ScoreSeqSet::calcLogOdds( std::vector<ScoreSeqSet*>( 1, set ), std::vector<float*>( 1, scores.data() ),
+							  std::vector<float*>( 1, ( float* )NULL ), qBits );
+	return scores;
+}
+
+// write the occurrences of a scan with qBits quantized scores into dir/basename.occurrence
+static void scan( Motif* motif, BackgroundModel* bg, std::vector<Sequence*> posSeqs,
+				  std::vector<Sequence*> negSeqs, float pvalCutoff, size_t qBits,
+				  std::string dir, std::string basename ){
+
+	size_t W = motif->getW();
+	ScoreSeqSet posSet( motif, bg, posSeqs );
+	ScoreSeqSet negSet( motif, bg, negSeqs );
+	std::vector<float> posScores = flatScores( &posSet, W, posSeqs.size(), qBits );
+	std::vector<float> negScores = flatScores( &negSet, W, negSeqs.size(), qBits );
+	if( qBits ){
+		ScoreSeqSet::rescoreQuantized( &negSet, negScores, &posSet, posScores, pvalCutoff, qBits );
+	}
+
+	std::vector<std::vector<float>> posSeqScores( posSeqs.size() );
+	for( size_t n = 0, offset = 0; n < posSeqs.size(); n++ ){
+		size_t LW1 = posSet.getPositions( n, W );
+		posSeqScores[n].assign( posScores.begin() + offset, posScores.begin() + offset + LW1 );
+		offset += LW1;
+	}
+	posSet.calcPvalues( posSeqScores, negScores );
+	posSet.write( const_cast<char*>( dir.c_str() ), basename, pvalCutoff, false, "occurrence" );
+}
+
+int main( int nargs, char* args[] ){
+
+	std::string example = initTest( nargs, args );
+	std::string dir = tempDirectory();
+
+	SequenceSet posSequences( example + "/JunD.fasta", false );
+	std::vector<Sequence*> seqs = posSequences.getSequences();
+	// the same sequences as negatives, with other letters drawn for unknown letters
+	SequenceSet negSequences( example + "/JunD.fasta", false );
+	BackgroundModel bg( example + "/JunD.hbcp" );
+
+	std::string bammPath = example + "/JunD_motif_1.ihbcp";
+	MotifSet bamm( const_cast<char*>( bammPath.c_str() ), 0, 0, "BaMM", NULL, bg.getV(), bg.getOrder(),
+				   2, std::vector<float>( 3, 1.0f ) );
+	std::string pwmPath = example + "/PWM_peng10.meme";
+	MotifSet pwms( const_cast<char*>( pwmPath.c_str() ), 0, 0, "PWM", &posSequences, bg.getV(), bg.getOrder(),
+				   0, std::vector<float>( 1, 1.0f ), 1 );
+	std::vector<Motif*> motifs = { bamm.getMotifs()[0], pwms.getMotifs()[0] };
+
+	size_t qBits[] = { 16, 8 };
+	for( size_t m = 0; m < motifs.size(); m++ ){
+
+		Motif* motif = motifs[m];
+		std::vector<std::vector<float>> expected = plainLogOdds( motif, &bg, seqs );
+		std::string floatFile = "float" + std::to_string( m );
+		scan( motif, &bg, seqs, negSequences.getSequences(), 1e-3f, 0, dir, floatFile );
+
+		for( size_t q : qBits ){
+
+			ScoreSeqSet set( motif, &bg, seqs );
+			float err = set.quantizationError( q );
+			std::vector<float> scores = flatScores( &set, motif->getW(), seqs.size(), q );
+
+			// all scores lie within the error bound, and are not just the float scores
+			size_t outside = 0;
+			size_t differ = 0;
+			for( size_t n = 0, i = 0; n < seqs.size(); n++ ){
+				for( size_t p = 0; p < expected[n].size(); p++, i++ ){
+					outside += ( fabsf( scores[i] - expected[n][p] ) > err );
+					differ += ( scores[i] != expected[n][p] );
+				}
+			}
+			CHECK( outside == 0 );
+			CHECK( differ > 0 );
+
+			// rescoring restores the float scores
+			std::vector<size_t> all( scores.size() );
+			for( size_t i = 0; i < all.size(); i++ ){
+				all[i] = i;
+			}
+			set.rescoreLogOdds( scores.data(), all );
+			std::vector<float> flat;
+			for( size_t n = 0; n < seqs.size(); n++ ){
+				flat.insert( flat.end(), expected[n].begin(), expected[n].end() );
+			}
+			CHECK( scores == flat );
+
+			// the reported occurrences are those of the float scan
+			std::string quantizedFile = "q" + std::to_string( q ) + '_' + std::to_string( m );
+			scan( motif, &bg, seqs, negSequences.getSequences(), 1e-3f, q, dir, quantizedFile );
+			std::vector<char> floatOccurrences = readFile( dir + '/' + floatFile + ".occurrence" );
+			CHECK( floatOccurrences.size() > 1000 );
+			CHECK( readFile( dir + '/' + quantizedFile + ".occurrence" ) == floatOccurrences );
+		}
+	}
+
+	removeDirectory( dir );
+	return finishTest();
+}
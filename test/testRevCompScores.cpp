@@ -0,0 +1,96 @@
+/*
+ * scoring the reverse strands of single-strand sequences by a reverse-complemented
+ * score table gives the scores of the plain scorer on the sequences with their
+ * reverse complements appended, wherever the windows and their contexts are known
+ */
+
+#include "testUtils.h"
+#include "plainScores.h"
+
+#include "../src/init/MotifSet.h"
+#include "../src/seq_scoring/ScoreSeqSet.h"
+
+int main( int nargs, char* args[] ){
+
+	std::string example = initTest( nargs, args );
+
+	SequenceSet singleStrand( example + "/JunD.fasta", true );
+	SequenceSet bothStrands( example + "/JunD.fasta", false );
+	std::vector<Sequence*> seqs = singleStrand.getSequences();
+	std::vector<Sequence*> seqs2 = bothStrands.getSequences();
+	BackgroundModel bg( example + "/JunD.hbcp" );
+
+	std::string bammPath = example + "/JunD_motif_1.ihbcp";
+	MotifSet bamm( const_cast<char*>( bammPath.c_str() ), 0, 0, "BaMM", NULL, bg.getV(), bg.getOrder(),
+				   2, std::vector<float>( 3, 1.0f ) );
+	std::string pwmPath = example + "/PWM_peng10.meme";
+	MotifSet pwms( const_cast<char*>( pwmPath.c_str() ), 0, 0, "PWM", &bothStrands, bg.getV(), bg.getOrder(),
+				   3, std::vector<float>( 4, 1.0f ), 1 );
+	std::vector<Motif*> motifs = { bamm.getMotifs()[0], pwms.getMotifs()[0] };
+
+	for( Motif* motif : motifs ){
+
+		size_t K = motif->getK();
+		size_t W = motif->getW();
+		std::vector<std::vector<float>> forward = plainLogOdds( motif, &bg, seqs );
+		std::vector<std::vector<float>> expected = plainLogOdds( motif, &bg, seqs2 );
+
+		ScoreSeqSet set( motif, &bg, seqs );
+		set.setRevComp( true );
+		set.calcLogOdds();
+		std::vector<std::vector<float>> scores = set.getMopsScores();
+		std::vector<float> zoops = set.getZoopsScores();
+		CHECK( scores.size() == seqs.size() );
+
+		size_t compared = 0;
+		size_t windows = 0;
+		size_t forwardMismatches = 0;
+		size_t reverseMismatches = 0;
+		for( size_t n = 0; n < seqs.size() and n < scores.size(); n++ ){
+			size_t L = seqs[n]->getL();
+			size_t LW1 = L - W + 1;
+			CHECK( scores[n].size() == 2 * LW1 );
+			if( scores[n].size() != 2 * LW1 ){
+				continue;
+			}
+
+			// the forward strand is scored as by the plain scorer
+			forwardMismatches += !std::equal( forward[n].begin(), forward[n].end(), scores[n].begin() );
+
+			// window r of the reverse strand starts at L+1+r of the sequence with its
+			// reverse complement; the columns are summed up in the opposite order
+			uint8_t* sequence = seqs2[n]->getSequence();
+			windows += LW1;
+			for( size_t r = 0; r < LW1; r++ ){
+				size_t p = L + 1 + r;
+				bool known = true;
+				for( size_t i = p - K; i < p + W; i++ ){
+					known = known and sequence[i] != 0;
+				}
+				if( known ){
+					compared++;
+					reverseMismatches += ( fabsf( scores[n][LW1 + r] - expected[n][p] ) > 1e-3f );
+				}
+			}
+			CHECK( zoops[n] == *std::max_element( scores[n].begin(), scores[n].end() ) );
+		}
+		CHECK( forwardMismatches == 0 );
+		CHECK( reverseMismatches == 0 );
+		CHECK( compared > windows * 9 / 10 );
+
+		// rescoring sums up the reverse strand as the scorer does
+		std::vector<float> flat;
+		for( size_t n = 0; n < scores.size(); n++ ){
+			flat.insert( flat.end(), scores[n].begin(), scores[n].end() );
+		}
+		std::vector<float> rescored( flat.size(), 0.0f );
+		std::vector<size_t> all( flat.size() );
+		for( size_t i = 0; i < all.size(); i++ ){
+			all[i] = i;
+		}
+		set.rescoreLogOdds( rescored.data(), all );
+		CHECK( rescored == flat );
+	}
+
+	return finishTest();
+}
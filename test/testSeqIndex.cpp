@@ -0,0 +1,141 @@
+/*
+ * the q-mer index lists each start position of each q-mer, also when it is read
+ * back from its store, and the scans seeded from it find the hits of the plain
+ * threshold scan
+ */
+
+#include "testUtils.h"
+#include "plainScores.h"
+
+#include "../src/init/MotifSet.h"
+#include "../src/seq_scoring/ScoreSeqSet.h"
+#include "../src/seq_scoring/SeqIndex.h"
+
+// the same positions of all q-mers, starts and ranges with unknown letters
+static bool equalIndices( SeqIndex& a, SeqIndex& b ){
+	if( a.getQ() != b.getQ() or a.getN() != b.getN() or a.getUnknown() != b.getUnknown() ){
+		return false;
+	}
+	for( size_t n = 0; n <= a.getN(); n++ ){
+		if( a.getStart( n ) != b.getStart( n ) ){
+			return false;
+		}
+	}
+	for( size_t x = 0; x < ipow( Alphabet::getSize(), a.getQ() ); x++ ){
+		size_t countA, countB;
+		const uint64_t* positionsA = a.getPositions( x, countA );
+		const uint64_t* positionsB = b.getPositions( x, countB );
+		if( countA != countB or !std::equal( positionsA, positionsA + countA, positionsB ) ){
+			return false;
+		}
+	}
+	return true;
+}
+
+// the occurrences of the hits, with the p-values of the given negative scores
+static std::vector<char> occurrences( ScoreSeqSet& set, std::vector<float> negScores,
+									  std::string dir, std::string basename ){
+	set.calcPvalues( set.getHitScores(), negScores );
+	set.write( const_cast<char*>( dir.c_str() ), basename, 1.0f, false, "occurrence" );
+	return readFile( dir + '/' + basename + ".occurrence" );
+}
+
+int main( int nargs, char* args[] ){
+
+	std::string example = initTest( nargs, args );
+	std::string dir = tempDirectory();
+
+	SequenceSet sequenceSet( example + "/JunD.fasta", false );
+	std::vector<Sequence*> seqs = sequenceSet.getSequences();
+	size_t q = 6;
+	size_t Yq = ipow( Alphabet::getSize(), q );
+
+	// the positions of the q-mers without unknown letters, by brute force
+	SeqIndex index( seqs, q );
+	size_t listed = 0;
+	size_t misplaced = 0;
+	for( size_t x = 0; x < Yq; x++ ){
+		size_t count;
+		const uint64_t* positions = index.getPositions( x, count );
+		listed += count;
+		for( size_t c = 0; c < count; c++ ){
+			size_t n = index.getSeq( positions[c] );
+			size_t p = positions[c] - index.getStart( n );
+			misplaced += ( c > 0 and positions[c] <= positions[c-1] )
+						 or p + q > seqs[n]->getL() or seqs[n]->getKmer()[p+q-1] % Yq != x;
+		}
+	}
+	size_t known = 0;
+	size_t unknown = 0;
+	for( size_t n = 0; n < seqs.size(); n++ ){
+		uint8_t* sequence = seqs[n]->getSequence();
+		for( size_t p = 0; p + q <= seqs[n]->getL(); p++ ){
+			bool isKnown = std::find( sequence + p, sequence + p + q, 0 ) == sequence + p + q;
+			known += isKnown;
+			unknown += !isKnown;
+		}
+	}
+	size_t ranges = 0;
+	for( auto& range : index.getUnknown() ){
+		ranges += range.second - range.first;
+	}
+	CHECK( misplaced == 0 );
+	CHECK( listed == known );
+	CHECK( ranges == unknown and unknown > 0 );
+
+	// built into the store, then read back from it
+	std::string store = dir + "/store";
+	SeqIndex built( seqs, q, const_cast<char*>( store.c_str() ) );
+	SeqIndex stored( seqs, q, const_cast<char*>( store.c_str() ) );
+	CHECK( equalIndices( index, built ) );
+	CHECK( equalIndices( index, stored ) );
+
+	// a damaged store is replaced
+	CHECK( system( ( "truncate -s -8 " + store + "/*.seqindex" ).c_str() ) == 0 );
+	SeqIndex rebuilt( seqs, q, const_cast<char*>( store.c_str() ) );
+	SeqIndex reread( seqs, q, const_cast<char*>( store.c_str() ) );
+	CHECK( equalIndices( index, rebuilt ) );
+	CHECK( equalIndices( index, reread ) );
+
+	// the seeded scans find the hits of the threshold scan, which are the
+	// positions of the plain scores from the score threshold on
+	BackgroundModel bg( example + "/JunD.hbcp" );
+	std::string bammPath = example + "/JunD_motif_1.ihbcp";
+	MotifSet bamm( const_cast<char*>( bammPath.c_str() ), 0, 0, "BaMM", NULL, bg.getV(), bg.getOrder(),
+				   2, std::vector<float>( 3, 1.0f ) );
+	Motif* motif = bamm.getMotifs()[0];
+	std::vector<std::vector<float>> expected = plainLogOdds( motif, &bg, seqs );
+	std::vector<float> negScores;
+	for( size_t n = 0; n < expected.size(); n++ ){
+		negScores.insert( negScores.end(), expected[n].begin(), expected[n].end() );
+	}
+	std::vector<float> sorted( negScores );
+	std::sort( sorted.begin(), sorted.end() );
+
+	float quantiles[] = { 0.99f, 0.999f, 0.9999f };
+	for( float quantile : quantiles ){
+		float minScore = sorted[( size_t )( quantile * sorted.size() )];
+
+		std::vector<std::vector<float>> hits( seqs.size() );
+		for( size_t n = 0; n < seqs.size(); n++ ){
+			std::copy_if( expected[n].begin(), expected[n].end(), std::back_inserter( hits[n] ),
+						  [minScore]( float score ){ return score >= minScore; } );
+		}
+
+		ScoreSeqSet scanned( motif, &bg, seqs );
+		scanned.calcHits( minScore );
+		CHECK( scanned.getHitScores() == hits );
+
+		ScoreSeqSet seeded( motif, &bg, seqs );
+		seeded.calcSeededHits( minScore, &stored );
+		CHECK( seeded.getHitScores() == hits );
+
+		std::string name = std::to_string( quantile );
+		std::vector<char> scannedOccurrences = occurrences( scanned, negScores, dir, "scanned" + name );
+		CHECK( scannedOccurrences.size() > 100 );
+		CHECK( occurrences( seeded, negScores, dir, "seeded" + name ) == scannedOccurrences );
+	}
+
+	removeDirectory( dir );
+	return finishTest();
+}
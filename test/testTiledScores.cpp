@@ -0,0 +1,95 @@
+/*
+ * the tiled scorer of motif batches gives the scores of the plain scorer,
+ * for single motifs and for groups of motifs which are scored in column
+ * tiles, on one thread and on several
+ */
+
+#ifdef OPENMP
+#include <omp.h>
+#endif
+
+#include "testUtils.h"
+#include "plainScores.h"
+
+#include "../src/init/MotifSet.h"
+#include "../src/seq_scoring/ScoreSeqSet.h"
+
+int main( int nargs, char* args[] ){
+
+	std::string example = initTest( nargs, args );
+
+	SequenceSet sequenceSet( example + "/JunD.fasta", false );
+	std::vector<Sequence*> seqs = sequenceSet.getSequences();
+	BackgroundModel bg( example + "/JunD.hbcp" );
+
+	// the JunD model of order 2, and PWMs extended to order 4, whose score tables
+	// of 4^5 entries per column only leave room for a single column per tile
+	std::string bammPath = example + "/JunD_motif_1.ihbcp";
+	MotifSet bamm( const_cast<char*>( bammPath.c_str() ), 0, 0, "BaMM", NULL, bg.getV(), bg.getOrder(),
+				   2, std::vector<float>( 3, 1.0f ) );
+	std::string pwmPath = example + "/PWM_peng10.meme";
+	MotifSet pwms( const_cast<char*>( pwmPath.c_str() ), 0, 0, "PWM", &sequenceSet, bg.getV(), bg.getOrder(),
+				   4, std::vector<float>( 5, 1.0f ), 3 );
+
+	CHECK( pwms.getN() == 3 and pwms.getMotifs()[0]->getK() == 4 );
+
+	std::vector<Motif*> motifs;
+	motifs.push_back( new Motif( *bamm.getMotifs()[0] ) );
+	for( size_t i = 0; i < pwms.getN(); i++ ){
+		motifs.push_back( new Motif( *pwms.getMotifs()[i] ) );
+	}
+	for( size_t c = 0; c < 80; c++ ){
+		motifs.push_back( new Motif( *pwms.getMotifs()[0] ) );
+	}
+	size_t M = motifs.size();
+
+	std::vector<std::vector<std::vector<float>>> expected( M );
+	for( size_t m = 0; m < M; m++ ){
+		expected[m] = plainLogOdds( motifs[m], &bg, seqs );
+	}
+
+	std::vector<ScoreSeqSet*> sets;
+	for( size_t m = 0; m < M; m++ ){
+		sets.push_back( new ScoreSeqSet( motifs[m], &bg, seqs ) );
+	}
+
+	size_t threads[] = { 1, 3 };
+	for( size_t t : threads ){
+#ifdef OPENMP
+		omp_set_num_threads( t );
+#endif
+		std::vector<std::vector<float>> mops( M );
+		std::vector<std::vector<float>> zoops( M, std::vector<float>( seqs.size() ) );
+		std::vector<float*> mopsBuffers, zoopsBuffers;
+		for( size_t m = 0; m < M; m++ ){
+			size_t positions = 0;
+			for( size_t n = 0; n < seqs.size(); n++ ){
+				positions += sets[m]->getPositions( n, motifs[m]->getW() );
+			}
+			mops[m].resize( positions );
+			mopsBuffers.push_back( mops[m].data() );
+			zoopsBuffers.push_back( zoops[m].data() );
+		}
+		ScoreSeqSet::calcLogOdds( sets, mopsBuffers, zoopsBuffers );
+
+		for( size_t m = 0; m < M; m++ ){
+			std::vector<float> flat;
+			for( size_t n = 0; n < seqs.size(); n++ ){
+				flat.insert( flat.end(), expected[m][n].begin(), expected[m][n].end() );
+			}
+			CHECK( mops[m] == flat );
+			CHECK( zoops[m] == plainZoops( expected[m] ) );
+		}
+	}
+
+	// the member scorer fills the scores of each sequence
+	sets[0]->calcLogOdds();
+	CHECK( sets[0]->getMopsScores() == expected[0] );
+	CHECK( sets[0]->getZoopsScores() == plainZoops( expected[0] ) );
+
+	for( size_t m = 0; m < M; m++ ){
+		delete sets[m];
+		delete motifs[m];
+	}
+	return finishTest();
+}
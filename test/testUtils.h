@@ -0,0 +1,88 @@
+#ifndef TESTUTILS_H_
+#define TESTUTILS_H_
+
+/*
+ * Helpers of the tests: each test is a program which runs its checks on the
+ * example data, given as its first argument, and returns the number of failed
+ * checks. The output files go into a temporary directory.
+ */
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <stdlib.h>		// e.g. mkdtemp
+#include <string.h>		// e.g. memcpy
+
+#include "../src/init/Alphabet.h"
+
+static int failures = 0;
+
+#define CHECK( condition ) \
+	do { \
+		if( !( condition ) ){ \
+			std::cerr << __FILE__ << ':' << __LINE__ << ": check failed: " #condition << std::endl; \
+			failures++; \
+		} \
+	} while( 0 )
+
+// the example directory from the command line, and the standard alphabet
+inline std::string initTest( int nargs, char* args[] ){
+	if( nargs < 2 ){
+		std::cerr << "Usage: " << args[0] << " EXAMPLE_DIR" << std::endl;
+		exit( 1 );
+	}
+	char alphabetType[] = "STANDARD";
+	Alphabet::init( alphabetType );
+	return std::string( args[1] );
+}
+
+// a new temporary directory, which is removed by removeDirectory()
+inline std::string tempDirectory(){
+	char dir[] = "/tmp/BaMMtestXXXXXX";
+	if( mkdtemp( dir ) == NULL ){
+		std::cerr << "Error: Cannot create a temporary directory." << std::endl;
+		exit( 1 );
+	}
+	return std::string( dir );
+}
+
+inline void removeDirectory( std::string dir ){
+	if( system( ( "rm -rf " + dir ).c_str() ) != 0 ){
+		std::cerr << "Warning: Cannot remove " << dir << std::endl;
+	}
+}
+
+// the contents of a binary file
+inline std::vector<char> readFile( std::string filePath ){
+	std::vector<char> data;
+	FILE* file = fopen( filePath.c_str(), "rb" );
+	if( file == NULL ){
+		return data;
+	}
+	char buffer[1 << 16];
+	size_t bytes;
+	while( ( bytes = fread( buffer, 1, sizeof( buffer ), file ) ) > 0 ){
+		data.insert( data.end(), buffer, buffer + bytes );
+	}
+	fclose( file );
+	return data;
+}
+
+// the value of type T at offset in data
+template<typename T>
+inline T valueAt( const std::vector<char>& data, size_t offset ){
+	T value;
+	memcpy( &value, data.data() + offset, sizeof( T ) );
+	return value;
+}
+
+inline int finishTest(){
+	Alphabet::destruct();
+	if( failures > 0 ){
+		std::cerr << failures << " checks failed" << std::endl;
+	}
+	return failures;
+}
+
+#endif /* TESTUTILS_H_ */